@@ -0,0 +1,61 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "FindSessionsCallbackProxy.h"
+#include "AdvancedSessionCache.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FBlueprintSessionCacheChangedDelegate, const TArray<FBlueprintSessionResult>&, ChangedSessions, const TArray<FString>&, RemovedSessionIds);
+
+// Every session the searches of this game instance have found, keyed by session id.
+// FindSessionsAdvanced feeds its results in as they arrive, so a browser can show what is cached straight away and only redraw the entries a refresh actually changed
+UCLASS()
+class ADVANCEDSESSIONS_API UAdvancedSessionCache : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+public:
+
+	// Sessions that were new or differed from the cached copy, and sessions that expired
+	UPROPERTY(BlueprintAssignable, Category = "Online|AdvancedSessions|Cache")
+	FBlueprintSessionCacheChangedDelegate OnSessionsChanged;
+
+	// Seconds a session stays cached after a search last saw it
+	UPROPERTY(BlueprintReadWrite, Category = "Online|AdvancedSessions|Cache")
+	float SessionTimeToLive = 60.0f;
+
+	// Ping moves on every search, it only counts as a change past this many milliseconds
+	UPROPERTY(BlueprintReadWrite, Category = "Online|AdvancedSessions|Cache")
+	int32 PingChangeThreshold = 10;
+
+	// Unexpired sessions from LAN or online searches, possibly stale
+	UFUNCTION(BlueprintCallable, Category = "Online|AdvancedSessions|Cache")
+	void GetCachedSessions(bool bLanSessions, TArray<FBlueprintSessionResult> &Sessions);
+
+	UFUNCTION(BlueprintCallable, Category = "Online|AdvancedSessions|Cache")
+	void ClearCache();
+
+	// Adds or refreshes the sessions, broadcasting only the ones that are new or changed
+	void UpdateSessions(const TArray<FBlueprintSessionResult> &Sessions, bool bLanSessions);
+
+	// Replaces the ping the search reported with a measured one, broadcast if it moved past the threshold
+	void UpdateSessionPing(const FString &SessionId, int32 PingMs);
+
+	// Drops sessions no search has seen within the time to live
+	void ExpireSessions();
+
+	static UAdvancedSessionCache* Get(const UObject* WorldContextObject);
+
+private:
+	struct FCachedSession
+	{
+		FBlueprintSessionResult Result;
+		double LastSeenTime = 0.0;
+		int32 MeasuredPingMs = -1; // Kept over what later searches report
+		bool bLan = false;
+	};
+
+	bool HasSessionChanged(const FOnlineSessionSearchResult &Cached, const FOnlineSessionSearchResult &Found) const;
+
+	TMap<FString, FCachedSession> Sessions;
+};
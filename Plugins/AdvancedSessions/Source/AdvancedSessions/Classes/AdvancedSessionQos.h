@@ -0,0 +1,115 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "FindSessionsCallbackProxy.h"
+#include "Containers/Ticker.h"
+#include "Containers/Queue.h"
+#include "Common/UdpSocketReceiver.h"
+#include "AdvancedSessionQos.generated.h"
+
+// Session setting a host advertises its QoS responder port under (value is int32)
+#define SETTING_ADVANCED_QOS_PORT FName(TEXT("ADVQOSPORT"))
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FBlueprintSessionQosCompleteDelegate);
+
+// Measures round trips to session hosts directly instead of trusting the ping the search reported.
+// Hosts answer on a small UDP echo responder. Clients probe up to MaxConcurrentProbes hosts at once through one shared socket and keep what they measured for a while.
+// Both sides receive on their own thread so replies are timed when they arrive, not when the game next ticks
+UCLASS()
+class ADVANCEDSESSIONS_API UAdvancedSessionQos : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+public:
+
+	// Called once every queued probe has finished
+	UPROPERTY(BlueprintAssignable, Category = "Online|AdvancedSessions|Qos")
+	FBlueprintSessionQosCompleteDelegate OnProbesComplete;
+
+	// Hosts probed at the same time, the rest wait their turn
+	UPROPERTY(BlueprintReadWrite, Category = "Online|AdvancedSessions|Qos")
+	int32 MaxConcurrentProbes = 16;
+
+	// Packets sent to each host, the fastest reply is its ping
+	UPROPERTY(BlueprintReadWrite, Category = "Online|AdvancedSessions|Qos")
+	int32 PacketsPerProbe = 3;
+
+	// Seconds a probe waits for replies before giving up on the host
+	UPROPERTY(BlueprintReadWrite, Category = "Online|AdvancedSessions|Qos")
+	float ProbeTimeout = 1.0f;
+
+	// Seconds a measured ping is reused before the host is probed again
+	UPROPERTY(BlueprintReadWrite, Category = "Online|AdvancedSessions|Qos")
+	float ResultTimeToLive = 30.0f;
+
+	// Host side, answers probes on this UDP port. Advertise it under SETTING_ADVANCED_QOS_PORT in the session's extra settings
+	UFUNCTION(BlueprintCallable, Category = "Online|AdvancedSessions|Qos")
+	bool StartResponder(int32 Port);
+
+	UFUNCTION(BlueprintCallable, Category = "Online|AdvancedSessions|Qos")
+	void StopResponder();
+
+	// Queues the sessions that advertise a responder and have no fresh measurement, already queued ones are skipped
+	UFUNCTION(BlueprintCallable, Category = "Online|AdvancedSessions|Qos")
+	void ProbeSessions(const TArray<FBlueprintSessionResult> &Sessions);
+
+	// Fills in measured pings and sorts by ping, lowest first. Sessions that were never measured keep the ping their search reported
+	UFUNCTION(BlueprintCallable, Category = "Online|AdvancedSessions|Qos")
+	void SortSessionsByPing(UPARAM(ref) TArray<FBlueprintSessionResult> &Sessions);
+
+	// -1 when the session hasn't been measured or didn't answer
+	UFUNCTION(BlueprintPure, Category = "Online|AdvancedSessions|Qos")
+	int32 GetMeasuredPing(const FBlueprintSessionResult &Session) const;
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+private:
+	struct FQosProbe
+	{
+		FString SessionId;
+		TSharedPtr<class FInternetAddr> HostAddress;
+		uint32 Nonce = 0; // Tells this probe's replies apart on the shared socket
+		TArray<double> SendTimes; // Indexed by packet sequence, 0 until sent
+		double Deadline = 0.0;
+		int32 Replies = 0;
+		int32 BestRoundTripMs = -1;
+	};
+
+	struct FQosReply
+	{
+		uint32 Nonce = 0;
+		uint8 Sequence = 0;
+		double ReceivedTime = 0.0;
+	};
+
+	struct FQosMeasurement
+	{
+		int32 PingMs = -1; // -1 if the host never answered
+		double MeasuredTime = 0.0;
+	};
+
+	bool Tick(float DeltaTime);
+	bool TickProbe(FQosProbe &Probe, double Now); // Sends the next packet when due, false once the probe is done
+	void FinishProbe(const FQosProbe &Probe, double Now);
+	bool OpenProbeSocket();
+	void CloseProbeSocket();
+	bool IsFresh(const FString &SessionId, double Now) const;
+
+	class FSocket* ResponderSocket = nullptr;
+	TUniquePtr<FUdpSocketReceiver> ResponderReceiver;
+
+	class FSocket* ProbeSocket = nullptr;
+	TUniquePtr<FUdpSocketReceiver> ProbeReceiver;
+	TQueue<FQosReply, EQueueMode::Mpsc> Replies; // Filled on the receive thread, drained on tick
+
+	TArray<FQosProbe> QueuedProbes;
+	TArray<FQosProbe> ActiveProbes;
+	TSet<FString> PendingSessionIds; // Queued or active
+	TMap<FString, FQosMeasurement> Measurements;
+	uint32 NextNonce = 0;
+	bool bProbesFinished = false;
+
+	FTSTicker::FDelegateHandle TickHandle;
+};
@@ -2,6 +2,7 @@
 #pragma once
 #include "CoreMinimal.h"
 #include "Engine/Engine.h"
+#include "Containers/Ticker.h"
 #include "Interfaces/OnlineSessionInterface.h"
 #include "FindSessionsCallbackProxy.h"
 #include "BlueprintDataDefinitions.h"
@@ -13,6 +14,40 @@ FORCEINLINE bool operator==(const FBlueprintSessionResult& A, const FBlueprintSe
 	return (A.OnlineResult.IsValid() == B.OnlineResult.IsValid() && (A.OnlineResult.GetSessionIdStr() == B.OnlineResult.GetSessionIdStr()));
 }
 
+// Search filters compiled once to be run against many results, same rules as CompareVariants.
+// Filters are grouped by key so each key is looked up once per result, and the filter values are read out of their variants up front
+struct FSessionResultFilter
+{
+public:
+	FSessionResultFilter() {}
+	explicit FSessionResultFilter(const TArray<FSessionsSearchSetting> &Filters);
+
+	// Sessions without a filtered key pass that filter, a key holding a different type fails it
+	bool Matches(const FOnlineSessionSearchResult &Result) const;
+
+	bool IsEmpty() const { return KeyFilters.Num() == 0; }
+
+private:
+	struct FPredicate
+	{
+		EOnlineComparisonOpRedux ComparisonOp = EOnlineComparisonOpRedux::Equals;
+		bool BoolValue = false;
+		int32 Int32Value = 0;
+		uint64 Int64Value = 0;
+		double NumberValue = 0.0; // Floats are compared as doubles
+		FString StringValue;
+	};
+
+	struct FKeyFilter
+	{
+		FName Key;
+		EOnlineKeyValuePairDataType::Type Type = EOnlineKeyValuePairDataType::Empty;
+		TArray<FPredicate> Predicates;
+	};
+
+	TArray<FKeyFilter> KeyFilters;
+};
+
 UCLASS(MinimalAPI)
 class UFindSessionsCallbackProxyAdvanced : public UOnlineBlueprintCallProxyBase
 {
@@ -26,9 +61,18 @@ class UFindSessionsCallbackProxyAdvanced : public UOnlineBlueprintCallProxyBase
 	UPROPERTY(BlueprintAssignable)
 	FBlueprintFindSessionsResultDelegate OnFailure;
 
+	// Called with each new page of filtered results while the search is still running, OnSuccess still gets every result at the end
+	UPROPERTY(BlueprintAssignable)
+	FBlueprintFindSessionsResultDelegate OnPage;
+
+	// Called straight away with the cached sessions that pass the filters, before the search has found anything. They may be stale
+	UPROPERTY(BlueprintAssignable)
+	FBlueprintFindSessionsResultDelegate OnCached;
+
 	// Searches for advertised sessions with the default online subsystem and includes an array of filters
+	// The filters are also applied locally as results come in, a PageSize of 0 sends one page when the search completes
 	UFUNCTION(BlueprintCallable, meta = (BlueprintInternalUseOnly = "true", WorldContext = "WorldContextObject", AutoCreateRefTerm="Filters"), Category = "Online|AdvancedSessions")
-	static UFindSessionsCallbackProxyAdvanced* FindSessionsAdvanced(UObject* WorldContextObject, class APlayerController* PlayerController, int32 MaxResults, bool bUseLAN, EBPServerPresenceSearchType ServerTypeToSearch, const TArray<FSessionsSearchSetting> &Filters, bool bEmptyServersOnly = false, bool bNonEmptyServersOnly = false, bool bSecureServersOnly = false, bool bSearchLobbies = true, int MinSlotsAvailable = 0);
+	static UFindSessionsCallbackProxyAdvanced* FindSessionsAdvanced(UObject* WorldContextObject, class APlayerController* PlayerController, int32 MaxResults, bool bUseLAN, EBPServerPresenceSearchType ServerTypeToSearch, const TArray<FSessionsSearchSetting> &Filters, bool bEmptyServersOnly = false, bool bNonEmptyServersOnly = false, bool bSecureServersOnly = false, bool bSearchLobbies = true, int MinSlotsAvailable = 0, int32 PageSize = 50);
 
 	static bool CompareVariants(const FVariantData &A, const FVariantData &B, EOnlineComparisonOpRedux Comparator);
 	
@@ -54,15 +98,34 @@ class UFindSessionsCallbackProxyAdvanced : public UOnlineBlueprintCallProxyBase
 	virtual void Activate() override;
 	// End of UOnlineBlueprintCallProxyBase interface
 
+	virtual void BeginDestroy() override;
+
 private:
 	// Internal callback when the session search completes, calls out to the public success/failure callbacks
 	void OnCompleted(bool bSuccess);
 
+	// Filters and pages whatever the running search has found since last time, subsystems like Null LAN add results as hosts reply
+	bool PollSearchResults(float DeltaTime);
+	void ConsumeSearchResults(const FOnlineSessionSearch &Search);
+	void StartPolling(TSharedPtr<FOnlineSessionSearch> Search);
+	void StopPolling();
+	void FlushPage();
+	void Finish(bool bFoundResults); // Sends the last page, then OnSuccess or OnFailure
+
 	bool bRunSecondSearch;
 	bool bIsOnSecondSearch;
 
 	TArray<FBlueprintSessionResult> SessionSearchResults;
 
+	FSessionResultFilter ResultFilter;
+	TSet<FString> SeenSessionIds; // Both searches can return the same session
+	TArray<FBlueprintSessionResult> PageResults;
+	int32 PageSize;
+
+	TSharedPtr<FOnlineSessionSearch> PolledSearch;
+	int32 ConsumedSearchResults;
+	FTSTicker::FDelegateHandle PollHandle;
+
 private:
 	// The player controller triggering things
 	TWeakObjectPtr<APlayerController> PlayerControllerWeakPtr;
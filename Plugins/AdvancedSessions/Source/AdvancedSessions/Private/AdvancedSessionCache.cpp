@@ -0,0 +1,126 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+#include "AdvancedSessionCache.h"
+#include "Engine/GameInstance.h"
+
+UAdvancedSessionCache* UAdvancedSessionCache::Get(const UObject* WorldContextObject)
+{
+	UWorld* const World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::ReturnNull);
+	UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+	return GameInstance ? GameInstance->GetSubsystem<UAdvancedSessionCache>() : nullptr;
+}
+
+void UAdvancedSessionCache::GetCachedSessions(bool bLanSessions, TArray<FBlueprintSessionResult> &OutSessions)
+{
+	ExpireSessions();
+
+	OutSessions.Reserve(OutSessions.Num() + Sessions.Num());
+	for (const TPair<FString, FCachedSession>& Session : Sessions)
+	{
+		if (Session.Value.bLan == bLanSessions)
+			OutSessions.Add(Session.Value.Result);
+	}
+}
+
+void UAdvancedSessionCache::ClearCache()
+{
+	TArray<FString> RemovedSessionIds;
+	Sessions.GetKeys(RemovedSessionIds);
+	Sessions.Reset();
+
+	if (RemovedSessionIds.Num() > 0)
+		OnSessionsChanged.Broadcast(TArray<FBlueprintSessionResult>(), RemovedSessionIds);
+}
+
+void UAdvancedSessionCache::UpdateSessions(const TArray<FBlueprintSessionResult> &Found, bool bLanSessions)
+{
+	const double Now = FPlatformTime::Seconds();
+	TArray<FBlueprintSessionResult> ChangedSessions;
+
+	for (const FBlueprintSessionResult& Result : Found)
+	{
+		if (!Result.OnlineResult.IsValid())
+			continue;
+
+		FCachedSession& Cached = Sessions.FindOrAdd(Result.OnlineResult.GetSessionIdStr());
+		const bool bIsNew = Cached.LastSeenTime == 0.0;
+		Cached.LastSeenTime = Now;
+		Cached.bLan = bLanSessions;
+
+		FBlueprintSessionResult Updated = Result;
+		if (Cached.MeasuredPingMs >= 0)
+			Updated.OnlineResult.PingInMs = Cached.MeasuredPingMs;
+
+		if (bIsNew || HasSessionChanged(Cached.Result.OnlineResult, Updated.OnlineResult))
+		{
+			Cached.Result = Updated;
+			ChangedSessions.Add(Updated);
+		}
+	}
+
+	if (ChangedSessions.Num() > 0)
+		OnSessionsChanged.Broadcast(ChangedSessions, TArray<FString>());
+}
+
+void UAdvancedSessionCache::UpdateSessionPing(const FString &SessionId, int32 PingMs)
+{
+	FCachedSession* Cached = Sessions.Find(SessionId);
+	if (!Cached)
+		return;
+
+	Cached->MeasuredPingMs = PingMs;
+	if (FMath::Abs(Cached->Result.OnlineResult.PingInMs - PingMs) < PingChangeThreshold)
+		return;
+
+	Cached->Result.OnlineResult.PingInMs = PingMs;
+
+	TArray<FBlueprintSessionResult> ChangedSessions;
+	ChangedSessions.Add(Cached->Result);
+	OnSessionsChanged.Broadcast(ChangedSessions, TArray<FString>());
+}
+
+void UAdvancedSessionCache::ExpireSessions()
+{
+	const double Oldest = FPlatformTime::Seconds() - SessionTimeToLive;
+	TArray<FString> RemovedSessionIds;
+
+	for (auto It = Sessions.CreateIterator(); It; ++It)
+	{
+		if (It.Value().LastSeenTime < Oldest)
+		{
+			RemovedSessionIds.Add(It.Key());
+			It.RemoveCurrent();
+		}
+	}
+
+	if (RemovedSessionIds.Num() > 0)
+		OnSessionsChanged.Broadcast(TArray<FBlueprintSessionResult>(), RemovedSessionIds);
+}
+
+bool UAdvancedSessionCache::HasSessionChanged(const FOnlineSessionSearchResult &Cached, const FOnlineSessionSearchResult &Found) const
+{
+	if (FMath::Abs(Cached.PingInMs - Found.PingInMs) >= PingChangeThreshold)
+		return true;
+
+	const FOnlineSession& CachedSession = Cached.Session;
+	const FOnlineSession& FoundSession = Found.Session;
+	if (CachedSession.NumOpenPublicConnections != FoundSession.NumOpenPublicConnections ||
+		CachedSession.NumOpenPrivateConnections != FoundSession.NumOpenPrivateConnections ||
+		CachedSession.OwningUserName != FoundSession.OwningUserName ||
+		CachedSession.SessionSettings.NumPublicConnections != FoundSession.SessionSettings.NumPublicConnections)
+		return true;
+
+	// Same keys holding the same values
+	const FSessionSettings& CachedSettings = CachedSession.SessionSettings.Settings;
+	const FSessionSettings& FoundSettings = FoundSession.SessionSettings.Settings;
+	if (CachedSettings.Num() != FoundSettings.Num())
+		return true;
+
+	for (const TPair<FName, FOnlineSessionSetting>& Setting : FoundSettings)
+	{
+		const FOnlineSessionSetting* CachedSetting = CachedSettings.Find(Setting.Key);
+		if (!CachedSetting || !(CachedSetting->Data == Setting.Value.Data))
+			return true;
+	}
+
+	return false;
+}
@@ -0,0 +1,310 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+#include "AdvancedSessionQos.h"
+#include "AdvancedSessionCache.h"
+#include "AdvancedSessionsLibrary.h"
+#include "Engine/GameInstance.h"
+#include "OnlineSubsystemUtils.h"
+#include "Common/UdpSocketBuilder.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "IPAddress.h"
+
+namespace AdvancedSessionQos
+{
+	// Magic, nonce, sequence. Replies are the request sent back with the reply magic
+	constexpr uint32 RequestMagic = 0x50515341; // "ASQP"
+	constexpr uint32 ReplyMagic = 0x52515341; // "ASQR"
+	constexpr int32 PacketSize = 9;
+
+	// Spreads a probe's packets out so one burst of loss doesn't take them all
+	constexpr double PacketInterval = 0.05;
+
+	uint32 ReadMagic(const uint8* Packet)
+	{
+		uint32 Magic;
+		FMemory::Memcpy(&Magic, Packet, sizeof(Magic));
+		return Magic;
+	}
+}
+
+void UAdvancedSessionQos::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	NextNonce = (uint32)FMath::Rand();
+	TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ThisClass::Tick));
+}
+
+void UAdvancedSessionQos::Deinitialize()
+{
+	FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+	TickHandle.Reset();
+
+	StopResponder();
+	CloseProbeSocket();
+	QueuedProbes.Reset();
+	ActiveProbes.Reset();
+	PendingSessionIds.Reset();
+
+	Super::Deinitialize();
+}
+
+bool UAdvancedSessionQos::StartResponder(int32 Port)
+{
+	StopResponder();
+
+	ResponderSocket = FUdpSocketBuilder(TEXT("AdvancedSessionQosResponder")).AsNonBlocking().BoundToPort(Port).Build();
+	if (!ResponderSocket)
+	{
+		UE_LOG(AdvancedSessionsLog, Warning, TEXT("Couldn't open the QoS responder on port %d"), Port);
+		return false;
+	}
+
+	// Answered straight from the receive thread, a reply waiting for the next game tick would add a frame to every ping
+	FSocket* Socket = ResponderSocket;
+	ResponderReceiver = MakeUnique<FUdpSocketReceiver>(ResponderSocket, FTimespan::FromMilliseconds(100), TEXT("AdvancedSessionQosResponder"));
+	ResponderReceiver->OnDataReceived().BindLambda([Socket](const FArrayReaderPtr& Data, const FIPv4Endpoint& Sender)
+	{
+		if (Data->Num() != AdvancedSessionQos::PacketSize || AdvancedSessionQos::ReadMagic(Data->GetData()) != AdvancedSessionQos::RequestMagic)
+			return;
+
+		uint8 Reply[AdvancedSessionQos::PacketSize];
+		FMemory::Memcpy(Reply, Data->GetData(), AdvancedSessionQos::PacketSize);
+		FMemory::Memcpy(Reply, &AdvancedSessionQos::ReplyMagic, sizeof(uint32));
+
+		int32 BytesSent = 0;
+		Socket->SendTo(Reply, AdvancedSessionQos::PacketSize, BytesSent, *Sender.ToInternetAddr());
+	});
+	ResponderReceiver->Start();
+	return true;
+}
+
+void UAdvancedSessionQos::StopResponder()
+{
+	// The receive thread has to be gone before the socket it reads
+	ResponderReceiver.Reset();
+
+	if (ResponderSocket)
+	{
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(ResponderSocket);
+		ResponderSocket = nullptr;
+	}
+}
+
+bool UAdvancedSessionQos::OpenProbeSocket()
+{
+	if (ProbeSocket)
+		return true;
+
+	ProbeSocket = FUdpSocketBuilder(TEXT("AdvancedSessionQosProbe")).AsNonBlocking().WithReceiveBufferSize(64 * 1024).Build();
+	if (!ProbeSocket)
+	{
+		UE_LOG(AdvancedSessionsLog, Warning, TEXT("Couldn't open a socket to probe sessions with"));
+		return false;
+	}
+
+	ProbeReceiver = MakeUnique<FUdpSocketReceiver>(ProbeSocket, FTimespan::FromMilliseconds(100), TEXT("AdvancedSessionQosProbe"));
+	ProbeReceiver->OnDataReceived().BindLambda([this](const FArrayReaderPtr& Data, const FIPv4Endpoint& Sender)
+	{
+		if (Data->Num() != AdvancedSessionQos::PacketSize || AdvancedSessionQos::ReadMagic(Data->GetData()) != AdvancedSessionQos::ReplyMagic)
+			return;
+
+		FQosReply Reply;
+		Reply.ReceivedTime = FPlatformTime::Seconds();
+		FMemory::Memcpy(&Reply.Nonce, Data->GetData() + sizeof(uint32), sizeof(uint32));
+		Reply.Sequence = (*Data)[AdvancedSessionQos::PacketSize - 1];
+		Replies.Enqueue(Reply);
+	});
+	ProbeReceiver->Start();
+	return true;
+}
+
+void UAdvancedSessionQos::CloseProbeSocket()
+{
+	ProbeReceiver.Reset();
+
+	if (ProbeSocket)
+	{
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(ProbeSocket);
+		ProbeSocket = nullptr;
+	}
+	Replies.Empty();
+}
+
+void UAdvancedSessionQos::ProbeSessions(const TArray<FBlueprintSessionResult> &Sessions)
+{
+	UWorld* World = GetGameInstance() ? GetGameInstance()->GetWorld() : nullptr;
+	IOnlineSessionPtr SessionInterface = Online::GetSessionInterface(World);
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	if (!SessionInterface.IsValid() || !SocketSubsystem || !OpenProbeSocket())
+		return;
+
+	const double Now = FPlatformTime::Seconds();
+	for (const FBlueprintSessionResult& Session : Sessions)
+	{
+		if (!Session.OnlineResult.IsValid())
+			continue;
+
+		const FString SessionId = Session.OnlineResult.GetSessionIdStr();
+		if (PendingSessionIds.Contains(SessionId) || IsFresh(SessionId, Now))
+			continue;
+
+		// Hosts that don't run a responder keep the ping their search reported
+		int32 QosPort = 0;
+		Session.OnlineResult.Session.SessionSettings.Get(SETTING_ADVANCED_QOS_PORT, QosPort);
+		if (QosPort <= 0 || QosPort > MAX_uint16)
+			continue;
+
+		FString ConnectString;
+		if (!SessionInterface->GetResolvedConnectString(Session.OnlineResult, NAME_GamePort, ConnectString))
+			continue;
+
+		FString Host = ConnectString;
+		ConnectString.Split(TEXT(":"), &Host, nullptr, ESearchCase::CaseSensitive, ESearchDir::FromEnd);
+
+		bool bIsValid = false;
+		TSharedRef<FInternetAddr> HostAddress = SocketSubsystem->CreateInternetAddr();
+		HostAddress->SetIp(*Host, bIsValid);
+		if (!bIsValid)
+			continue;
+		HostAddress->SetPort(QosPort);
+
+		FQosProbe& Probe = QueuedProbes.AddDefaulted_GetRef();
+		Probe.SessionId = SessionId;
+		Probe.HostAddress = HostAddress;
+		PendingSessionIds.Add(SessionId);
+	}
+}
+
+bool UAdvancedSessionQos::Tick(float DeltaTime)
+{
+	const double Now = FPlatformTime::Seconds();
+
+	FQosReply Reply;
+	while (Replies.Dequeue(Reply))
+	{
+		FQosProbe* Probe = ActiveProbes.FindByPredicate([&Reply](const FQosProbe& Active) { return Active.Nonce == Reply.Nonce; });
+		if (!Probe || !Probe->SendTimes.IsValidIndex(Reply.Sequence) || Probe->SendTimes[Reply.Sequence] == 0.0)
+			continue;
+
+		const int32 RoundTripMs = FMath::Max(FMath::RoundToInt((Reply.ReceivedTime - Probe->SendTimes[Reply.Sequence]) * 1000.0), 0);
+		Probe->BestRoundTripMs = Probe->BestRoundTripMs < 0 ? RoundTripMs : FMath::Min(Probe->BestRoundTripMs, RoundTripMs);
+		Probe->Replies++;
+	}
+
+	for (int32 i = ActiveProbes.Num() - 1; i >= 0; i--)
+	{
+		if (!TickProbe(ActiveProbes[i], Now))
+		{
+			FinishProbe(ActiveProbes[i], Now);
+			ActiveProbes.RemoveAtSwap(i);
+		}
+	}
+
+	// Queued probes wait for a free slot, oldest first
+	const int32 NumToStart = FMath::Min(QueuedProbes.Num(), FMath::Max(MaxConcurrentProbes, 1) - ActiveProbes.Num());
+	for (int32 i = 0; i < NumToStart; i++)
+	{
+		FQosProbe& Probe = ActiveProbes.Add_GetRef(MoveTemp(QueuedProbes[i]));
+		Probe.Nonce = NextNonce++;
+		Probe.SendTimes.Init(0.0, FMath::Clamp(PacketsPerProbe, 1, 255));
+		Probe.Deadline = Now + (Probe.SendTimes.Num() - 1) * AdvancedSessionQos::PacketInterval + ProbeTimeout;
+		TickProbe(Probe, Now);
+	}
+	if (NumToStart > 0)
+		QueuedProbes.RemoveAt(0, NumToStart);
+
+	if (bProbesFinished && ActiveProbes.Num() == 0 && QueuedProbes.Num() == 0)
+	{
+		bProbesFinished = false;
+		OnProbesComplete.Broadcast();
+	}
+
+	return true;
+}
+
+bool UAdvancedSessionQos::TickProbe(FQosProbe &Probe, double Now)
+{
+	if (Probe.Replies >= Probe.SendTimes.Num() || Now >= Probe.Deadline || !ProbeSocket)
+		return false;
+
+	for (int32 Sequence = 0; Sequence < Probe.SendTimes.Num(); Sequence++)
+	{
+		if (Probe.SendTimes[Sequence] != 0.0)
+			continue;
+
+		const double PreviousSendTime = Sequence > 0 ? Probe.SendTimes[Sequence - 1] : 0.0;
+		if (Sequence > 0 && Now < PreviousSendTime + AdvancedSessionQos::PacketInterval)
+			break;
+
+		uint8 Packet[AdvancedSessionQos::PacketSize];
+		FMemory::Memcpy(Packet, &AdvancedSessionQos::RequestMagic, sizeof(uint32));
+		FMemory::Memcpy(Packet + sizeof(uint32), &Probe.Nonce, sizeof(uint32));
+		Packet[AdvancedSessionQos::PacketSize - 1] = (uint8)Sequence;
+
+		int32 BytesSent = 0;
+		Probe.SendTimes[Sequence] = FPlatformTime::Seconds();
+		ProbeSocket->SendTo(Packet, AdvancedSessionQos::PacketSize, BytesSent, *Probe.HostAddress);
+		break;
+	}
+
+	return true;
+}
+
+void UAdvancedSessionQos::FinishProbe(const FQosProbe &Probe, double Now)
+{
+	FQosMeasurement& Measurement = Measurements.FindOrAdd(Probe.SessionId);
+	Measurement.PingMs = Probe.BestRoundTripMs;
+	Measurement.MeasuredTime = Now;
+	PendingSessionIds.Remove(Probe.SessionId);
+	bProbesFinished = true;
+
+	// Cached browsers see the new ping as a change to that session
+	if (Probe.BestRoundTripMs >= 0)
+	{
+		if (UAdvancedSessionCache* Cache = GetGameInstance() ? GetGameInstance()->GetSubsystem<UAdvancedSessionCache>() : nullptr)
+			Cache->UpdateSessionPing(Probe.SessionId, Probe.BestRoundTripMs);
+	}
+}
+
+bool UAdvancedSessionQos::IsFresh(const FString &SessionId, double Now) const
+{
+	const FQosMeasurement* Measurement = Measurements.Find(SessionId);
+	return Measurement && Now - Measurement->MeasuredTime < ResultTimeToLive;
+}
+
+int32 UAdvancedSessionQos::GetMeasuredPing(const FBlueprintSessionResult &Session) const
+{
+	const FQosMeasurement* Measurement = Session.OnlineResult.IsValid() ? Measurements.Find(Session.OnlineResult.GetSessionIdStr()) : nullptr;
+	return Measurement ? Measurement->PingMs : -1;
+}
+
+void UAdvancedSessionQos::SortSessionsByPing(TArray<FBlueprintSessionResult> &Sessions)
+{
+	const double Now = FPlatformTime::Seconds();
+
+	// Keys worked out once per session rather than per comparison. Hosts that were probed and never answered go last, they are likely unreachable whatever the search said
+	TArray<TPair<int32, int32>> SortKeys; // Ping, index
+	SortKeys.Reserve(Sessions.Num());
+	for (int32 i = 0; i < Sessions.Num(); i++)
+	{
+		FOnlineSessionSearchResult& Result = Sessions[i].OnlineResult;
+		int32 SortPing = Result.PingInMs;
+
+		const FQosMeasurement* Measurement = Result.IsValid() ? Measurements.Find(Result.GetSessionIdStr()) : nullptr;
+		if (Measurement && Now - Measurement->MeasuredTime < ResultTimeToLive)
+		{
+			if (Measurement->PingMs >= 0)
+				Result.PingInMs = Measurement->PingMs;
+			SortPing = Measurement->PingMs >= 0 ? Measurement->PingMs : MAX_int32;
+		}
+		SortKeys.Emplace(SortPing, i);
+	}
+
+	SortKeys.StableSort([](const TPair<int32, int32>& A, const TPair<int32, int32>& B) { return A.Key < B.Key; });
+
+	TArray<FBlueprintSessionResult> Sorted;
+	Sorted.Reserve(Sessions.Num());
+	for (const TPair<int32, int32>& SortKey : SortKeys)
+		Sorted.Add(MoveTemp(Sessions[SortKey.Value]));
+	Sessions = MoveTemp(Sorted);
+}
@@ -1,5 +1,6 @@
 // Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
 #include "FindSessionsCallbackProxyAdvanced.h"
+#include "AdvancedSessionCache.h"
 
 #include "Online/OnlineSessionNames.h"
 
@@ -14,9 +15,11 @@ UFindSessionsCallbackProxyAdvanced::UFindSessionsCallbackProxyAdvanced(const FOb
 {
 	bRunSecondSearch = false;
 	bIsOnSecondSearch = false;
+	PageSize = 0;
+	ConsumedSearchResults = 0;
 }
 
-UFindSessionsCallbackProxyAdvanced* UFindSessionsCallbackProxyAdvanced::FindSessionsAdvanced(UObject* WorldContextObject, class APlayerController* PlayerController, int MaxResults, bool bUseLAN, EBPServerPresenceSearchType ServerTypeToSearch, const TArray<FSessionsSearchSetting> &Filters, bool bEmptyServersOnly, bool bNonEmptyServersOnly, bool bSecureServersOnly, bool bSearchLobbies, int MinSlotsAvailable)
+UFindSessionsCallbackProxyAdvanced* UFindSessionsCallbackProxyAdvanced::FindSessionsAdvanced(UObject* WorldContextObject, class APlayerController* PlayerController, int MaxResults, bool bUseLAN, EBPServerPresenceSearchType ServerTypeToSearch, const TArray<FSessionsSearchSetting> &Filters, bool bEmptyServersOnly, bool bNonEmptyServersOnly, bool bSecureServersOnly, bool bSearchLobbies, int MinSlotsAvailable, int32 PageSize)
 {
 	UFindSessionsCallbackProxyAdvanced* Proxy = NewObject<UFindSessionsCallbackProxyAdvanced>();	
 	Proxy->PlayerControllerWeakPtr = PlayerController;
@@ -30,6 +33,7 @@ UFindSessionsCallbackProxyAdvanced* UFindSessionsCallbackProxyAdvanced::FindSess
 	Proxy->bSecureServersOnly = bSecureServersOnly;
 	Proxy->bSearchLobbies = bSearchLobbies;
 	Proxy->MinSlotsAvailable = MinSlotsAvailable;
+	Proxy->PageSize = FMath::Max(PageSize, 0);
 	return Proxy;
 }
 
@@ -46,6 +50,19 @@ void UFindSessionsCallbackProxyAdvanced::Activate()
 			// Re-initialize here, otherwise I think there might be issues with people re-calling search for some reason before it is destroyed
 			bRunSecondSearch = false;
 			bIsOnSecondSearch = false;
+			ResultFilter = FSessionResultFilter(SearchSettings);
+			SeenSessionIds.Reset();
+			PageResults.Reset();
+
+			// Whatever earlier searches found can be shown while this one runs
+			if (UAdvancedSessionCache* Cache = UAdvancedSessionCache::Get(WorldContextObject.Get()))
+			{
+				TArray<FBlueprintSessionResult> CachedResults;
+				Cache->GetCachedSessions(bUseLAN, CachedResults);
+				CachedResults.RemoveAll([this](const FBlueprintSessionResult& Result) { return !ResultFilter.Matches(Result.OnlineResult); });
+				if (CachedResults.Num() > 0)
+					OnCached.Broadcast(CachedResults);
+			}
 
 			DelegateHandle = Sessions->AddOnFindSessionsCompleteDelegate_Handle(Delegate);
 
@@ -155,6 +172,7 @@ void UFindSessionsCallbackProxyAdvanced::Activate()
 			// Copy the derived temp variable over to it's base class
 			SearchObject->QuerySettings = tem;
 
+			StartPolling(SearchObject);
 			Sessions->FindSessions(*Helper.UserID, SearchObject.ToSharedRef());
 
 			// OnQueryCompleted will get called, nothing more to do now
@@ -167,7 +185,7 @@ void UFindSessionsCallbackProxyAdvanced::Activate()
 	}
 
 	// Fail immediately
-	OnFailure.Broadcast(SessionSearchResults);
+	Finish(false);
 }
 
 void UFindSessionsCallbackProxyAdvanced::OnCompleted(bool bSuccess)
@@ -178,7 +196,7 @@ void UFindSessionsCallbackProxyAdvanced::OnCompleted(bool bSuccess)
 	if (!Helper.IsValid())
 	{
 		// Fail immediately
-		OnFailure.Broadcast(SessionSearchResults);
+		Finish(false);
 		return;
 	}
 
@@ -197,18 +215,8 @@ void UFindSessionsCallbackProxyAdvanced::OnCompleted(bool bSuccess)
 		{
 			if (SearchObjectDedicated.IsValid())
 			{
-				// Just log the results for now, will need to add a blueprint-compatible search result struct
-				for (auto& Result : SearchObjectDedicated->SearchResults)
-				{
-					FString ResultText = FString::Printf(TEXT("Found a session. Ping is %d"), Result.PingInMs);
-
-					FFrame::KismetExecutionMessage(*ResultText, ELogVerbosity::Log);
-
-					FBlueprintSessionResult BPResult;
-					BPResult.OnlineResult = Result;
-					SessionSearchResults.AddUnique(BPResult);
-				}
-				OnSuccess.Broadcast(SessionSearchResults);
+				ConsumeSearchResults(*SearchObjectDedicated);
+				Finish(true);
 				return;
 			}
 		}
@@ -216,20 +224,10 @@ void UFindSessionsCallbackProxyAdvanced::OnCompleted(bool bSuccess)
 		{
 			if (SearchObject.IsValid())
 			{
-				// Just log the results for now, will need to add a blueprint-compatible search result struct
-				for (auto& Result : SearchObject->SearchResults)
-				{
-					FString ResultText = FString::Printf(TEXT("Found a session. Ping is %d"), Result.PingInMs);
-
-					FFrame::KismetExecutionMessage(*ResultText, ELogVerbosity::Log);
-
-					FBlueprintSessionResult BPResult;
-					BPResult.OnlineResult = Result;
-					SessionSearchResults.AddUnique(BPResult);
-				}
+				ConsumeSearchResults(*SearchObject);
 				if (!bRunSecondSearch)
 				{
-					OnSuccess.Broadcast(SessionSearchResults);
+					Finish(true);
 					return;
 				}
 			}
@@ -240,10 +238,7 @@ void UFindSessionsCallbackProxyAdvanced::OnCompleted(bool bSuccess)
 		if (!bRunSecondSearch)
 		{
 			// Need to account for only one of the searches failing
-			if (SessionSearchResults.Num() > 0)
-				OnSuccess.Broadcast(SessionSearchResults);
-			else
-				OnFailure.Broadcast(SessionSearchResults);
+			Finish(SessionSearchResults.Num() > 0);
 			return;
 		}
 	}
@@ -253,49 +248,287 @@ void UFindSessionsCallbackProxyAdvanced::OnCompleted(bool bSuccess)
 		bRunSecondSearch = false;
 		bIsOnSecondSearch = true;
 		auto Sessions = Helper.OnlineSub->GetSessionInterface();
+		StartPolling(SearchObjectDedicated);
 		Sessions->FindSessions(*Helper.UserID, SearchObjectDedicated.ToSharedRef());
 	}
 	else // We lost our player controller
 	{
-		if (bSuccess && SessionSearchResults.Num() > 0)
-			OnSuccess.Broadcast(SessionSearchResults);
-		else
-			OnFailure.Broadcast(SessionSearchResults);
+		Finish(bSuccess && SessionSearchResults.Num() > 0);
 	}
 }
 
+void UFindSessionsCallbackProxyAdvanced::BeginDestroy()
+{
+	StopPolling();
+	Super::BeginDestroy();
+}
+
+void UFindSessionsCallbackProxyAdvanced::StartPolling(TSharedPtr<FOnlineSessionSearch> Search)
+{
+	StopPolling();
+	PolledSearch = Search;
+	ConsumedSearchResults = 0;
+	PollHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ThisClass::PollSearchResults));
+}
+
+void UFindSessionsCallbackProxyAdvanced::StopPolling()
+{
+	if (PollHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(PollHandle);
+		PollHandle.Reset();
+	}
+}
+
+bool UFindSessionsCallbackProxyAdvanced::PollSearchResults(float DeltaTime)
+{
+	if (!PolledSearch.IsValid())
+		return false;
+
+	if (PolledSearch->SearchState == EOnlineAsyncTaskState::InProgress)
+		ConsumeSearchResults(*PolledSearch);
+
+	return true;
+}
+
+void UFindSessionsCallbackProxyAdvanced::ConsumeSearchResults(const FOnlineSessionSearch &Search)
+{
+	// Some subsystems rebuild the array when they finish, start over and let the seen ids skip repeats
+	if (Search.SearchResults.Num() < ConsumedSearchResults)
+		ConsumedSearchResults = 0;
+
+	// Everything found is cached, filtered or not, later searches filter it their own way
+	TArray<FBlueprintSessionResult> NewResults;
+
+	for (int32 i = ConsumedSearchResults; i < Search.SearchResults.Num(); i++)
+	{
+		const FOnlineSessionSearchResult& Result = Search.SearchResults[i];
+
+		bool bAlreadySeen = false;
+		SeenSessionIds.Add(Result.IsValid() ? Result.GetSessionIdStr() : FString(), &bAlreadySeen);
+		if (bAlreadySeen)
+			continue;
+
+		FBlueprintSessionResult BPResult;
+		BPResult.OnlineResult = Result;
+		NewResults.Add(BPResult);
+
+		if (!ResultFilter.Matches(Result))
+			continue;
+
+		FString ResultText = FString::Printf(TEXT("Found a session. Ping is %d"), Result.PingInMs);
+		FFrame::KismetExecutionMessage(*ResultText, ELogVerbosity::Log);
+
+		SessionSearchResults.Add(BPResult);
+		PageResults.Add(BPResult);
+
+		if (PageSize > 0 && PageResults.Num() >= PageSize)
+			FlushPage();
+	}
+	ConsumedSearchResults = Search.SearchResults.Num();
+
+	if (NewResults.Num() > 0)
+	{
+		if (UAdvancedSessionCache* Cache = UAdvancedSessionCache::Get(WorldContextObject.Get()))
+			Cache->UpdateSessions(NewResults, bUseLAN);
+	}
+}
+
+void UFindSessionsCallbackProxyAdvanced::FlushPage()
+{
+	if (PageResults.Num() == 0)
+		return;
+
+	// Moved out first, listeners may start another search from the page
+	TArray<FBlueprintSessionResult> Page = MoveTemp(PageResults);
+	PageResults.Reset();
+	OnPage.Broadcast(Page);
+}
+
+void UFindSessionsCallbackProxyAdvanced::Finish(bool bFoundResults)
+{
+	StopPolling();
+	PolledSearch.Reset();
+	FlushPage();
+
+	if (UAdvancedSessionCache* Cache = UAdvancedSessionCache::Get(WorldContextObject.Get()))
+		Cache->ExpireSessions();
+
+	if (bFoundResults)
+		OnSuccess.Broadcast(SessionSearchResults);
+	else
+		OnFailure.Broadcast(SessionSearchResults);
+}
+
 
 void UFindSessionsCallbackProxyAdvanced::FilterSessionResults(const TArray<FBlueprintSessionResult> &SessionResults, const TArray<FSessionsSearchSetting> &Filters, TArray<FBlueprintSessionResult> &FilteredResults)
 {
+	// Compiled once for the whole array rather than reading every filter's variant for every result
+	const FSessionResultFilter Filter(Filters);
+	FilteredResults.Reserve(FilteredResults.Num() + SessionResults.Num());
+
 	for (int j = 0; j < SessionResults.Num(); j++)
 	{
-		bool bAddResult = true;
+		if (Filter.Matches(SessionResults[j].OnlineResult))
+			FilteredResults.Add(SessionResults[j]);
+	}
+}
+
+FSessionResultFilter::FSessionResultFilter(const TArray<FSessionsSearchSetting> &Filters)
+{
+	for (const FSessionsSearchSetting& Filter : Filters)
+	{
+		const FVariantData& Data = Filter.PropertyKeyPair.Data;
 
-		// Filter results
-		if (Filters.Num() > 0)
+		FKeyFilter* KeyFilter = KeyFilters.FindByPredicate([&](const FKeyFilter& Existing)
 		{
-			const FOnlineSessionSetting * setting;
-			for (int i = 0; i < Filters.Num(); i++)
-			{
-				setting = SessionResults[j].OnlineResult.Session.SessionSettings.Settings.Find(Filters[i].PropertyKeyPair.Key);
+			return Existing.Key == Filter.PropertyKeyPair.Key && Existing.Type == Data.GetType();
+		});
 
-				// Couldn't find this key
-				if (!setting)
-					continue;
+		if (!KeyFilter)
+		{
+			KeyFilter = &KeyFilters.AddDefaulted_GetRef();
+			KeyFilter->Key = Filter.PropertyKeyPair.Key;
+			KeyFilter->Type = Data.GetType();
+		}
 
-				if (!CompareVariants(setting->Data, Filters[i].PropertyKeyPair.Data, Filters[i].ComparisonOp))
-				{
-					bAddResult = false;
-					break;
-				}
+		FPredicate& Predicate = KeyFilter->Predicates.AddDefaulted_GetRef();
+		Predicate.ComparisonOp = Filter.ComparisonOp;
+
+		switch (Data.GetType())
+		{
+		case EOnlineKeyValuePairDataType::Bool: Data.GetValue(Predicate.BoolValue); break;
+		case EOnlineKeyValuePairDataType::Int32: Data.GetValue(Predicate.Int32Value); break;
+		case EOnlineKeyValuePairDataType::Int64: Data.GetValue(Predicate.Int64Value); break;
+		case EOnlineKeyValuePairDataType::Double: Data.GetValue(Predicate.NumberValue); break;
+		case EOnlineKeyValuePairDataType::Float:
+		{
+			float Value;
+			Data.GetValue(Value);
+			Predicate.NumberValue = (double)Value;
+		}
+		break;
+		case EOnlineKeyValuePairDataType::String: Data.GetValue(Predicate.StringValue); break;
+		default: break;
+		}
+	}
+}
+
+template<typename T>
+static bool CompareOrdered(const T &A, const T &B, EOnlineComparisonOpRedux Comparator)
+{
+	switch (Comparator)
+	{
+	case EOnlineComparisonOpRedux::Equals: return A == B;
+	case EOnlineComparisonOpRedux::NotEquals: return A != B;
+	case EOnlineComparisonOpRedux::GreaterThanEquals: return A >= B;
+	case EOnlineComparisonOpRedux::LessThanEquals: return A <= B;
+	case EOnlineComparisonOpRedux::GreaterThan: return A > B;
+	case EOnlineComparisonOpRedux::LessThan: return A < B;
+	default: return false;
+	}
+}
+
+template<typename T>
+static bool CompareEquality(const T &A, const T &B, EOnlineComparisonOpRedux Comparator)
+{
+	switch (Comparator)
+	{
+	case EOnlineComparisonOpRedux::Equals: return A == B;
+	case EOnlineComparisonOpRedux::NotEquals: return A != B;
+	default: return false;
+	}
+}
+
+bool FSessionResultFilter::Matches(const FOnlineSessionSearchResult &Result) const
+{
+	for (const FKeyFilter& KeyFilter : KeyFilters)
+	{
+		const FOnlineSessionSetting* Setting = Result.Session.SessionSettings.Settings.Find(KeyFilter.Key);
+
+		// Couldn't find this key
+		if (!Setting)
+			continue;
+
+		if (Setting->Data.GetType() != KeyFilter.Type)
+			return false;
+
+		// The session's value is read once for every filter on its key
+		switch (KeyFilter.Type)
+		{
+		case EOnlineKeyValuePairDataType::Bool:
+		{
+			bool Value;
+			Setting->Data.GetValue(Value);
+			for (const FPredicate& Predicate : KeyFilter.Predicates)
+			{
+				if (!CompareEquality(Value, Predicate.BoolValue, Predicate.ComparisonOp))
+					return false;
 			}
 		}
+		break;
+		case EOnlineKeyValuePairDataType::Int32:
+		{
+			int32 Value;
+			Setting->Data.GetValue(Value);
+			for (const FPredicate& Predicate : KeyFilter.Predicates)
+			{
+				if (!CompareOrdered(Value, Predicate.Int32Value, Predicate.ComparisonOp))
+					return false;
+			}
+		}
+		break;
+		case EOnlineKeyValuePairDataType::Int64:
+		{
+			uint64 Value;
+			Setting->Data.GetValue(Value);
+			for (const FPredicate& Predicate : KeyFilter.Predicates)
+			{
+				if (!CompareOrdered(Value, Predicate.Int64Value, Predicate.ComparisonOp))
+					return false;
+			}
+		}
+		break;
+		case EOnlineKeyValuePairDataType::Float:
+		case EOnlineKeyValuePairDataType::Double:
+		{
+			double Value;
+			if (KeyFilter.Type == EOnlineKeyValuePairDataType::Float)
+			{
+				float FloatValue;
+				Setting->Data.GetValue(FloatValue);
+				Value = (double)FloatValue;
+			}
+			else
+			{
+				Setting->Data.GetValue(Value);
+			}
 
-		if (bAddResult)
-			FilteredResults.Add(SessionResults[j]);
+			for (const FPredicate& Predicate : KeyFilter.Predicates)
+			{
+				if (!CompareOrdered(Value, Predicate.NumberValue, Predicate.ComparisonOp))
+					return false;
+			}
+		}
+		break;
+		case EOnlineKeyValuePairDataType::String:
+		{
+			FString Value;
+			Setting->Data.GetValue(Value);
+			for (const FPredicate& Predicate : KeyFilter.Predicates)
+			{
+				if (!CompareEquality(Value, Predicate.StringValue, Predicate.ComparisonOp))
+					return false;
+			}
+		}
+		break;
+		default:
+			// Empty and blob settings never compare, same as CompareVariants
+			return false;
+		}
 	}
 
-	return;
+	return true;
 }
 
 
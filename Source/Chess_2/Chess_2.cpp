@@ -4,3 +4,75 @@
 #include "Modules/ModuleManager.h"
 
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, Chess_2, "Chess_2" );
+
+TAutoConsoleVariable<int32> CVarChessNetDormancy(
+	TEXT("Chess.NetDormancy"),
+	1,
+	TEXT("1 = board squares and chess pieces stay net dormant between moves, 0 = they are considered for replication every net frame. Read when the actors begin play."),
+	ECVF_Default);
+
+TAutoConsoleVariable<int32> CVarChessLockstep(
+	TEXT("Chess.Lockstep"),
+	0,
+	TEXT("1 = matches only send sequenced moves and every peer simulates them, pieces and squares stop replicating after the opening sync. Read when a match starts."),
+	ECVF_Default);
+
+TAutoConsoleVariable<int32> CVarChessLockstepHashInterval(
+	TEXT("Chess.LockstepHashInterval"),
+	4,
+	TEXT("Moves between lockstep position hash checks, a mismatch resyncs that client from the server."),
+	ECVF_Default);
+
+TAutoConsoleVariable<float> CVarChessSpectatorDelay(
+	TEXT("Chess.SpectatorDelay"),
+	10.0f,
+	TEXT("Seconds moves are held back before spectators see them."),
+	ECVF_Default);
+
+TAutoConsoleVariable<int32> CVarChessSpectatorBuckets(
+	TEXT("Chess.SpectatorBuckets"),
+	4,
+	TEXT("Spectator connections are spread over this many net frames by the replication graph, so each frame only serves a share of them."),
+	ECVF_Default);
+
+TAutoConsoleVariable<int32> CVarChessRecordReplays(
+	TEXT("Chess.RecordReplays"),
+	1,
+	TEXT("1 = the server writes every match to Saved/Replays as it is played. Read when a match starts."),
+	ECVF_Default);
+
+TAutoConsoleVariable<int32> CVarChessReplaySnapshotInterval(
+	TEXT("Chess.ReplaySnapshotInterval"),
+	16,
+	TEXT("Plies between full position snapshots in replay files, seeking replays at most this many moves."),
+	ECVF_Default);
+
+TAutoConsoleVariable<FString> CVarChessStartFen(
+	TEXT("Chess.StartFen"),
+	TEXT(""),
+	TEXT("FEN matches are set up from, pieces missing from the level are spawned and extra ones removed. Empty = the level's own setup. Read when a match starts."),
+	ECVF_Default);
+
+TAutoConsoleVariable<float> CVarChessClockBase(
+	TEXT("Chess.ClockBase"),
+	0.0f,
+	TEXT("Seconds each player starts with, 0 = no clocks. Read when a match starts."),
+	ECVF_Default);
+
+TAutoConsoleVariable<float> CVarChessClockIncrement(
+	TEXT("Chess.ClockIncrement"),
+	0.0f,
+	TEXT("Seconds added to a player's clock after each of their moves. Read when a match starts."),
+	ECVF_Default);
+
+TAutoConsoleVariable<float> CVarChessClockDelay(
+	TEXT("Chess.ClockDelay"),
+	0.0f,
+	TEXT("Seconds at the start of every turn before the clock starts running. Read when a match starts."),
+	ECVF_Default);
+
+TAutoConsoleVariable<int32> CVarChessClockMaxLatencyCredit(
+	TEXT("Chess.ClockMaxLatencyCredit"),
+	500,
+	TEXT("Most milliseconds a move is given back for the time it took to reach the server, half the mover's ping up to this."),
+	ECVF_Default);
@@ -3,4 +3,39 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "HAL/IConsoleManager.h"
+#include "Stats/Stats.h"
 
+DECLARE_STATS_GROUP(TEXT("Chess"), STATGROUP_Chess, STATCAT_Advanced);
+
+// 1 keeps board squares and chess pieces net dormant until a move touches them, 0 keeps them awake every net frame
+extern TAutoConsoleVariable<int32> CVarChessNetDormancy;
+
+// 1 starts new matches in lockstep, only moves are sent and every peer plays them on its own FChessPosition
+extern TAutoConsoleVariable<int32> CVarChessLockstep;
+
+// Lockstep clients send their position hash to the server every this many moves
+extern TAutoConsoleVariable<int32> CVarChessLockstepHashInterval;
+
+// Seconds the spectator feed holds moves back
+extern TAutoConsoleVariable<float> CVarChessSpectatorDelay;
+
+// Spectators are split into this many buckets, each replicated on its own net frame
+extern TAutoConsoleVariable<int32> CVarChessSpectatorBuckets;
+
+// 1 streams every match's moves to Saved/Replays
+extern TAutoConsoleVariable<int32> CVarChessRecordReplays;
+
+// Plies between full position snapshots in replay files
+extern TAutoConsoleVariable<int32> CVarChessReplaySnapshotInterval;
+
+// FEN new matches start from, empty keeps the pieces as placed in the level
+extern TAutoConsoleVariable<FString> CVarChessStartFen;
+
+// Chess clock for new matches: base time, increment and delay in seconds. A base of 0 plays without clocks
+extern TAutoConsoleVariable<float> CVarChessClockBase;
+extern TAutoConsoleVariable<float> CVarChessClockIncrement;
+extern TAutoConsoleVariable<float> CVarChessClockDelay;
+
+// Most a move is credited for its time in flight, in milliseconds
+extern TAutoConsoleVariable<int32> CVarChessClockMaxLatencyCredit;
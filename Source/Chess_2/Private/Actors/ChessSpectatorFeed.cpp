@@ -0,0 +1,109 @@
+// Copyright (©) 2024, Van Phan. All rights reserved.
+
+
+#include "Actors/ChessSpectatorFeed.h"
+#include "Actors/ChessBoard.h"
+#include "PlayerStates/ChessPlayerState.h"
+#include "Networking/ChessReplicationGraph.h"
+#include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
+#include "Chess_2.h"
+
+AChessSpectatorFeed::AChessSpectatorFeed()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	bReplicates = true;
+	SetReplicatingMovement(false);
+	NetUpdateFrequency = 2.0f; // Moves are seconds apart and already delayed, nobody notices half a second more
+	if (!RootComponent) RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("RootComponent"));
+}
+
+void AChessSpectatorFeed::ResetFeed(AChessBoard* NewBoard, const FChessPosition& StartPosition)
+{
+	Board = NewBoard;
+	DelayedPosition = StartPosition;
+	DelayedSequence = 0;
+	RecentMoves.Reset();
+	PendingMoves.Reset();
+
+	MARK_PROPERTY_DIRTY_FROM_NAME(AChessSpectatorFeed, Board, this);
+	MARK_PROPERTY_DIRTY_FROM_NAME(AChessSpectatorFeed, DelayedPosition, this);
+	MARK_PROPERTY_DIRTY_FROM_NAME(AChessSpectatorFeed, DelayedSequence, this);
+	MARK_PROPERTY_DIRTY_FROM_NAME(AChessSpectatorFeed, RecentMoves, this);
+	UChessReplicationGraph::NotifyMatchesChanged(GetWorld());
+}
+
+void AChessSpectatorFeed::RecordMove(int32 Sequence, uint16 Move)
+{
+	FChessDelayedMove DelayedMove;
+	DelayedMove.ReleaseTime = GetWorld()->GetTimeSeconds() + FMath::Max(CVarChessSpectatorDelay.GetValueOnGameThread(), 0.0f);
+	DelayedMove.Sequence = Sequence;
+	DelayedMove.Move = Move;
+	PendingMoves.Add(DelayedMove);
+}
+
+void AChessSpectatorFeed::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (!HasAuthority() || PendingMoves.IsEmpty()) return;
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	int32 NumReleased = 0;
+	while (NumReleased < PendingMoves.Num() && PendingMoves[NumReleased].ReleaseTime <= Now)
+	{
+		const FChessDelayedMove& DelayedMove = PendingMoves[NumReleased++];
+		DelayedPosition.ApplyMove(DelayedMove.Move);
+		DelayedSequence = DelayedMove.Sequence;
+		RecentMoves.Add(DelayedMove.Move);
+	}
+	if (NumReleased == 0) return;
+
+	PendingMoves.RemoveAt(0, NumReleased);
+	if (RecentMoves.Num() > 16) RecentMoves.RemoveAt(0, RecentMoves.Num() - 16);
+
+	MARK_PROPERTY_DIRTY_FROM_NAME(AChessSpectatorFeed, DelayedPosition, this);
+	MARK_PROPERTY_DIRTY_FROM_NAME(AChessSpectatorFeed, DelayedSequence, this);
+	MARK_PROPERTY_DIRTY_FROM_NAME(AChessSpectatorFeed, RecentMoves, this);
+}
+
+void AChessSpectatorFeed::OnRep_Feed()
+{
+	// The three properties can land in separate frames, wait until they agree
+	if (!Board || RecentMoves.Num() > DelayedSequence) return;
+
+	// Play the recent moves when we're only a few behind, otherwise jump straight to the delayed position
+	const int32 FirstRecentSequence = DelayedSequence - RecentMoves.Num() + 1;
+	const int32 LocalSequence = Board->GetMoveSequence();
+	if (LocalSequence >= FirstRecentSequence - 1 && LocalSequence < DelayedSequence && Board->GetPosition().CountPieces() > 0)
+	{
+		for (int32 Sequence = LocalSequence + 1; Sequence <= DelayedSequence; Sequence++)
+		{
+			if (!Board->ApplyReceivedMove(Sequence, RecentMoves[Sequence - FirstRecentSequence])) break;
+		}
+	}
+	if (Board->GetMoveSequence() != DelayedSequence || Board->GetPosition() != DelayedPosition)
+	{
+		Board->ApplyReceivedPosition(DelayedPosition, DelayedSequence);
+	}
+}
+
+bool AChessSpectatorFeed::IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const
+{
+	// Only the spectators watching this board, players get the real thing
+	const APlayerController* Viewer = Cast<APlayerController>(RealViewer);
+	const AChessPlayerState* ViewerState = Viewer ? Viewer->GetPlayerState<AChessPlayerState>() : nullptr;
+	return ViewerState && ViewerState->bIsSpectator && ViewerState->ChessBoard == Board;
+}
+
+void AChessSpectatorFeed::GetLifetimeReplicatedProps(TArray<FLifetimeProperty> &OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	FDoRepLifetimeParams PushParams;
+	PushParams.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(AChessSpectatorFeed, Board, PushParams);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AChessSpectatorFeed, DelayedPosition, PushParams);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AChessSpectatorFeed, DelayedSequence, PushParams);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AChessSpectatorFeed, RecentMoves, PushParams);
+}
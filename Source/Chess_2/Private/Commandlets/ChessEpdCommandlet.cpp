@@ -0,0 +1,238 @@
+// Copyright (©) 2024, Van Phan. All rights reserved.
+
+
+#include "Commandlets/ChessEpdCommandlet.h"
+#include "Utility/ChessSearch.h"
+#include "Async/Async.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/Paths.h"
+
+namespace
+{
+    struct FChessEpdEntry
+    {
+        FString Id;
+        FChessPosition Position;
+        TArray<uint16> BestMoves;
+        TArray<uint16> AvoidMoves;
+
+        bool IsSolution(uint16 Move) const { return BestMoves.Num() > 0 ? BestMoves.Contains(Move) : !AvoidMoves.Contains(Move); }
+    };
+
+    struct FChessEpdOutcome
+    {
+        FString Id;
+        FString PlayedSan;
+        bool bSolved = false;
+        double TimeToSolution = 0.0;
+        uint64 Nodes = 0;
+        double Seconds = 0.0;
+    };
+
+    // Hands out one line at a time from a fixed size buffer, so the suite is never loaded whole
+    class FChessEpdLineReader
+    {
+    public:
+        explicit FChessEpdLineReader(FArchive* InArchive) : Archive(InArchive) {}
+
+        bool ReadLine(FString& OutLine)
+        {
+            TArray<ANSICHAR, TInlineAllocator<512>> Line;
+            bool bReadAnything = false;
+            while (true)
+            {
+                if (BufferPosition >= BufferLength && !Refill()) break;
+                bReadAnything = true;
+
+                const ANSICHAR Character = (ANSICHAR)Buffer[BufferPosition++];
+                if (Character == '\n') break;
+                if (Character != '\r' && Line.Num() < MaxLineLength) Line.Add(Character); // Anything longer isn't EPD, it's dropped rather than buffered
+            }
+            if (!bReadAnything) return false;
+
+            Line.Add('\0');
+            OutLine = UTF8_TO_TCHAR(Line.GetData());
+            return true;
+        }
+
+    private:
+        static constexpr int32 MaxLineLength = 4096;
+
+        TUniquePtr<FArchive> Archive;
+        uint8 Buffer[64 * 1024];
+        int64 BufferPosition = 0;
+        int64 BufferLength = 0;
+
+        bool Refill()
+        {
+            BufferPosition = 0;
+            BufferLength = FMath::Min<int64>(sizeof(Buffer), Archive->TotalSize() - Archive->Tell());
+            if (BufferLength <= 0) return false;
+            Archive->Serialize(Buffer, BufferLength);
+            return true;
+        }
+    };
+
+    TArray<uint16> ParseSanList(const FChessPosition& Position, const FString& Operand)
+    {
+        TArray<FString> Sans;
+        Operand.ParseIntoArrayWS(Sans);
+
+        TArray<uint16> Moves;
+        for (const FString& San : Sans)
+        {
+            const uint16 Move = FChessMoveGenerator::ParseSan(Position, San);
+            if (Move != ChessMove::None) Moves.Add(Move);
+        }
+        return Moves;
+    }
+
+    // Four FEN fields then "opcode operand;" pairs, only bm, am and id are read
+    bool ParseEpdLine(const FString& Line, FChessEpdEntry& OutEntry)
+    {
+        int32 FieldsEnd = 0;
+        for (int32 Field = 0; Field < 4; Field++)
+        {
+            while (FieldsEnd < Line.Len() && FChar::IsWhitespace(Line[FieldsEnd])) FieldsEnd++;
+            while (FieldsEnd < Line.Len() && !FChar::IsWhitespace(Line[FieldsEnd])) FieldsEnd++;
+        }
+        if (!OutEntry.Position.SetFromFen(Line.Left(FieldsEnd))) return false;
+
+        TArray<FString> Operations;
+        Line.Mid(FieldsEnd).ParseIntoArray(Operations, TEXT(";"));
+        for (const FString& Operation : Operations)
+        {
+            const FString Trimmed = Operation.TrimStartAndEnd();
+            FString Opcode;
+            FString Operand;
+            if (!Trimmed.Split(TEXT(" "), &Opcode, &Operand)) continue;
+
+            if (Opcode == TEXT("bm")) OutEntry.BestMoves = ParseSanList(OutEntry.Position, Operand);
+            else if (Opcode == TEXT("am")) OutEntry.AvoidMoves = ParseSanList(OutEntry.Position, Operand);
+            else if (Opcode == TEXT("id")) OutEntry.Id = Operand.TrimStartAndEnd().TrimQuotes();
+        }
+        return OutEntry.BestMoves.Num() > 0 || OutEntry.AvoidMoves.Num() > 0;
+    }
+
+    FChessEpdOutcome SearchEntry(const FChessEpdEntry& Entry, const FChessSearchLimits& Limits)
+    {
+        // Solved from the first depth that found the answer and never changed its mind after
+        double SolvedAt = -1.0;
+        FChessSearch Search;
+        const FChessSearchResult Result = Search.Search(Entry.Position, Limits, nullptr, [&Entry, &SolvedAt](const FChessSearchResult& DepthResult)
+        {
+            if (!Entry.IsSolution(DepthResult.BestMove)) SolvedAt = -1.0;
+            else if (SolvedAt < 0.0) SolvedAt = DepthResult.Seconds;
+        });
+
+        FChessEpdOutcome Outcome;
+        Outcome.Id = Entry.Id;
+        Outcome.PlayedSan = Result.BestMove != ChessMove::None ? FChessMoveGenerator::MoveToSan(Entry.Position, Result.BestMove) : TEXT("-");
+        Outcome.bSolved = Entry.IsSolution(Result.BestMove) && Result.BestMove != ChessMove::None;
+        Outcome.TimeToSolution = Outcome.bSolved ? FMath::Max(SolvedAt, 0.0) : 0.0;
+        Outcome.Nodes = Result.Nodes;
+        Outcome.Seconds = Result.Seconds;
+        return Outcome;
+    }
+}
+
+UChessEpdCommandlet::UChessEpdCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+}
+
+int32 UChessEpdCommandlet::Main(const FString& Params)
+{
+    FString Filename;
+    if (!FParse::Value(*Params, TEXT("File="), Filename))
+    {
+        UE_LOG(LogTemp, Error, TEXT("Usage: -run=ChessEpd -File=<suite.epd> [-MoveTime=ms] [-Nodes=n] [-Threads=n]"));
+        return 1;
+    }
+    if (FPaths::IsRelative(Filename)) Filename = FPaths::ProjectDir() / Filename;
+
+    FArchive* Archive = IFileManager::Get().CreateFileReader(*Filename);
+    if (!Archive)
+    {
+        UE_LOG(LogTemp, Error, TEXT("Can't open %s"), *Filename);
+        return 1;
+    }
+    FChessEpdLineReader Reader(Archive);
+
+    int32 MoveTimeMs = 0;
+    int64 NodeLimit = 0;
+    int32 NumThreads = FMath::Max(FPlatformMisc::NumberOfWorkerThreadsToSpawn(), 1);
+    FParse::Value(*Params, TEXT("MoveTime="), MoveTimeMs);
+    FParse::Value(*Params, TEXT("Nodes="), NodeLimit);
+    FParse::Value(*Params, TEXT("Threads="), NumThreads);
+    NumThreads = FMath::Max(NumThreads, 1);
+
+    FChessSearchLimits Limits;
+    Limits.TimeLimitSeconds = (MoveTimeMs > 0 || NodeLimit <= 0) ? (MoveTimeMs > 0 ? MoveTimeMs : 1000) / 1000.0 : 0.0;
+    Limits.NodeLimit = (uint64)FMath::Max<int64>(NodeLimit, 0);
+
+    int32 NumPositions = 0;
+    int32 NumSolved = 0;
+    int32 NumSkipped = 0;
+    double TotalTimeToSolution = 0.0;
+    double TotalSearchSeconds = 0.0;
+    uint64 TotalNodes = 0;
+    const double StartTime = FPlatformTime::Seconds();
+
+    TArray<TFuture<FChessEpdOutcome>> InFlight;
+    auto CollectFinished = [&](bool bWait)
+    {
+        for (int32 Index = InFlight.Num() - 1; Index >= 0; Index--)
+        {
+            if (!bWait && !InFlight[Index].IsReady()) continue;
+
+            const FChessEpdOutcome Outcome = InFlight[Index].Get();
+            InFlight.RemoveAtSwap(Index);
+
+            NumPositions++;
+            TotalNodes += Outcome.Nodes;
+            TotalSearchSeconds += Outcome.Seconds;
+            if (Outcome.bSolved)
+            {
+                NumSolved++;
+                TotalTimeToSolution += Outcome.TimeToSolution;
+            }
+            UE_LOG(LogTemp, Display, TEXT("%s %s played %s"), *Outcome.Id, Outcome.bSolved ? TEXT("solved") : TEXT("failed"), *Outcome.PlayedSan);
+        }
+    };
+
+    FString Line;
+    while (Reader.ReadLine(Line))
+    {
+        Line.TrimStartAndEndInline();
+        if (Line.IsEmpty() || Line.StartsWith(TEXT("#"))) continue;
+
+        FChessEpdEntry Entry;
+        if (!ParseEpdLine(Line, Entry))
+        {
+            NumSkipped++;
+            continue;
+        }
+        if (Entry.Id.IsEmpty()) Entry.Id = FString::Printf(TEXT("#%d"), NumPositions + InFlight.Num() + NumSkipped + 1);
+
+        // Never more positions in memory than there are workers searching them
+        while (InFlight.Num() >= NumThreads)
+        {
+            CollectFinished(false);
+            if (InFlight.Num() >= NumThreads) FPlatformProcess::Sleep(0.001f);
+        }
+        InFlight.Add(Async(EAsyncExecution::ThreadPool, [Entry = MoveTemp(Entry), Limits]() { return SearchEntry(Entry, Limits); }));
+    }
+    CollectFinished(true);
+
+    const double WallSeconds = FPlatformTime::Seconds() - StartTime;
+    UE_LOG(LogTemp, Display, TEXT("%s: solved %d of %d (%d skipped), average time to solution %.3f s"),
+        *FPaths::GetCleanFilename(Filename), NumSolved, NumPositions, NumSkipped, NumSolved > 0 ? TotalTimeToSolution / NumSolved : 0.0);
+    UE_LOG(LogTemp, Display, TEXT("%llu nodes, %.0f NPS per worker, %.0f NPS over %d workers"),
+        TotalNodes, TotalSearchSeconds > 0.0 ? TotalNodes / TotalSearchSeconds : 0.0, WallSeconds > 0.0 ? TotalNodes / WallSeconds : 0.0, NumThreads);
+    return 0;
+}
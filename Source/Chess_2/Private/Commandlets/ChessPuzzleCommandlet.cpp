@@ -0,0 +1,89 @@
+// Copyright (©) 2024, Van Phan. All rights reserved.
+
+
+#include "Commandlets/ChessPuzzleCommandlet.h"
+#include "Utility/ChessPuzzleDatabase.h"
+#include "Utility/ChessMoveGenerator.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace
+{
+    // Lichess columns: PuzzleId, FEN, Moves, Rating, RatingDeviation, Popularity, NbPlays, Themes, GameUrl, OpeningTags
+    bool ParseLichessLine(FStringView Line, FChessPuzzle& OutPuzzle)
+    {
+        TArray<FString> Fields;
+        FString(Line).ParseIntoArray(Fields, TEXT(","), false);
+        if (Fields.Num() < 8 || Fields[0] == TEXT("PuzzleId")) return false;
+
+        FChessPosition Position;
+        TArray<FString> Moves;
+        Fields[2].ParseIntoArrayWS(Moves);
+        if (!Position.SetFromFen(Fields[1]) || Moves.Num() < 2) return false;
+
+        // The opponent's move sets the puzzle up, it isn't part of the solution
+        const uint16 SetupMove = FChessMoveGenerator::ParseUci(Position, Moves[0]);
+        if (SetupMove == ChessMove::None) return false;
+        Position.ApplyMove(SetupMove);
+        OutPuzzle.Fen = Position.ToFen();
+
+        for (int32 Index = 1; Index < Moves.Num(); Index++)
+        {
+            const uint16 Move = FChessMoveGenerator::ParseUci(Position, Moves[Index]);
+            if (Move == ChessMove::None) return false;
+            OutPuzzle.Solution.Add(Move);
+            Position.ApplyMove(Move);
+        }
+
+        OutPuzzle.Rating = (uint16)FMath::Clamp(FCString::Atoi(*Fields[3]), 0, (int32)MAX_uint16);
+
+        TArray<FString> Themes;
+        Fields[7].ParseIntoArrayWS(Themes);
+        for (const FString& ThemeName : Themes)
+        {
+            const int32 Theme = ChessPuzzleTheme::FindTheme(ThemeName);
+            if (Theme != INDEX_NONE) OutPuzzle.Themes |= 1u << Theme;
+        }
+        return true;
+    }
+}
+
+UChessPuzzleCommandlet::UChessPuzzleCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+}
+
+int32 UChessPuzzleCommandlet::Main(const FString& Params)
+{
+    FString InFilename;
+    if (!FParse::Value(*Params, TEXT("In="), InFilename))
+    {
+        UE_LOG(LogTemp, Error, TEXT("Usage: -run=ChessPuzzle -In=<lichess_db_puzzle.csv> [-Out=<database>]"));
+        return 1;
+    }
+    if (FPaths::IsRelative(InFilename)) InFilename = FPaths::ProjectDir() / InFilename;
+
+    FString OutFilename = FChessPuzzleDatabase::GetDefaultFilename();
+    if (FParse::Value(*Params, TEXT("Out="), OutFilename) && FPaths::IsRelative(OutFilename)) OutFilename = FPaths::ProjectDir() / OutFilename;
+
+    TArray<FChessPuzzle> Puzzles;
+    int32 NumDropped = 0;
+    const bool bRead = FFileHelper::LoadFileToStringWithLineVisitor(*InFilename, [&Puzzles, &NumDropped](FStringView Line)
+    {
+        FChessPuzzle Puzzle;
+        if (Line.IsEmpty()) return;
+        if (ParseLichessLine(Line, Puzzle) && Puzzle.IsPlayable() && Puzzle.Solution.Num() <= ChessPuzzleFormat::MaxSolutionMoves) Puzzles.Add(MoveTemp(Puzzle));
+        else NumDropped++;
+    });
+    if (!bRead)
+    {
+        UE_LOG(LogTemp, Error, TEXT("Can't read %s"), *InFilename);
+        return 1;
+    }
+
+    UE_LOG(LogTemp, Display, TEXT("%d puzzles read, %d dropped"), Puzzles.Num(), NumDropped);
+    return FChessPuzzleDatabase::Write(OutFilename, MoveTemp(Puzzles)) ? 0 : 1;
+}
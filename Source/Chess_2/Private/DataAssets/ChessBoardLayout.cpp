@@ -0,0 +1,24 @@
+// Copyright (©) 2024, Van Phan. All rights reserved.
+
+
+#include "DataAssets/ChessBoardLayout.h"
+#include "Actors/BaseChessPiece.h"
+
+TSubclassOf<ABaseChessPiece> UChessBoardLayout::GetPieceClass(uint8 PieceType) const
+{
+    switch (PieceType)
+    {
+        case ChessPiece::Pawn:   return PawnPieceClass;
+        case ChessPiece::Knight: return KnightPieceClass;
+        case ChessPiece::Bishop: return BishopPieceClass;
+        case ChessPiece::Rook:   return RookPieceClass;
+        case ChessPiece::Queen:  return QueenPieceClass;
+        case ChessPiece::King:   return KingPieceClass;
+        default:                 return nullptr;
+    }
+}
+
+FVector UChessBoardLayout::GetSquareOffset(int32 SquareIndex) const
+{
+    return A1Offset + FVector(FChessPosition::GetFile(SquareIndex) * SquareSize, FChessPosition::GetRank(SquareIndex) * SquareSize, 0.0f);
+}
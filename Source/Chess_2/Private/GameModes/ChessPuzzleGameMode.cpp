@@ -0,0 +1,164 @@
+// Copyright (©) 2024, Van Phan. All rights reserved.
+
+
+#include "GameModes/ChessPuzzleGameMode.h"
+#include "Actors/ChessBoard.h"
+#include "PlayerControllers/ChessPlayer.h"
+#include "PlayerStates/ChessPlayerState.h"
+#include "Subsystems/ChessMatchSubsystem.h"
+#include "Subsystems/ChessPuzzleSubsystem.h"
+#include "Utility/ChessMoveGenerator.h"
+#include "Kismet/GameplayStatics.h"
+#include "TimerManager.h"
+#include "Engine/World.h"
+
+void AChessPuzzleGameMode::InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage)
+{
+    Super::InitGame(MapName, Options, ErrorMessage);
+
+    MinRating = UGameplayStatics::GetIntOption(Options, TEXT("MinRating"), 0);
+    MaxRating = UGameplayStatics::GetIntOption(Options, TEXT("MaxRating"), MAX_uint16);
+
+    const FString ThemeName = UGameplayStatics::ParseOption(Options, TEXT("Theme"));
+    Theme = ThemeName.IsEmpty() ? INDEX_NONE : ChessPuzzleTheme::FindTheme(ThemeName);
+    if (!ThemeName.IsEmpty() && Theme == INDEX_NONE) UE_LOG(LogTemp, Warning, TEXT("Unknown puzzle theme %s, picking from every theme"), *ThemeName);
+}
+
+void AChessPuzzleGameMode::PlayerReady(AChessPlayer* Player)
+{
+    AChessPlayerState* ChessPlayerState = Player ? Player->GetPlayerState<AChessPlayerState>() : nullptr;
+    if (!ChessPlayerState || ChessPlayerState->bIsSpectator) return;
+
+    UChessMatchSubsystem* MatchSubsystem = GetWorld()->GetSubsystem<UChessMatchSubsystem>();
+    const int32 MatchId = MatchSubsystem ? MatchSubsystem->StartSoloMatch(Player) : INDEX_NONE;
+    FChessMatch* Match = MatchSubsystem ? MatchSubsystem->FindMatch(MatchId) : nullptr;
+    if (!Match || !Match->Board) return;
+
+    if (!Match->Board->IsBoardReady())
+    {
+        Match->Board->OnBoardReady.AddUObject(this, &ThisClass::HandleBoardReady);
+        return;
+    }
+    StartPuzzle(Match->Board, Player);
+}
+
+void AChessPuzzleGameMode::HandleBoardReady(AChessBoard* ChessBoard)
+{
+    ChessBoard->OnBoardReady.RemoveAll(this);
+
+    UChessMatchSubsystem* MatchSubsystem = GetWorld()->GetSubsystem<UChessMatchSubsystem>();
+    const FChessMatch* Match = MatchSubsystem ? MatchSubsystem->FindMatch(ChessBoard->GetMatchId()) : nullptr;
+    if (Match) StartPuzzle(ChessBoard, Match->WhitePlayer);
+}
+
+void AChessPuzzleGameMode::Logout(AController* Exiting)
+{
+    for (auto It = Attempts.CreateIterator(); It; ++It)
+    {
+        if (It.Value().Solver == Exiting) It.RemoveCurrent();
+    }
+    Super::Logout(Exiting);
+}
+
+void AChessPuzzleGameMode::NextPuzzle()
+{
+    TArray<TPair<AChessBoard*, AChessPlayer*>> Solvers;
+    for (const TPair<TObjectKey<AChessBoard>, FChessPuzzleAttempt>& Attempt : Attempts)
+    {
+        AChessBoard* ChessBoard = Attempt.Key.ResolveObjectPtr();
+        if (ChessBoard && Attempt.Value.Solver.IsValid()) Solvers.Emplace(ChessBoard, Attempt.Value.Solver.Get());
+    }
+
+    for (const TPair<AChessBoard*, AChessPlayer*>& Solver : Solvers) StartPuzzle(Solver.Key, Solver.Value);
+}
+
+void AChessPuzzleGameMode::StartPuzzle(AChessBoard* ChessBoard, AChessPlayer* Solver)
+{
+    if (!ChessBoard || !Solver) return;
+
+    UChessPuzzleSubsystem* PuzzleSubsystem = GetGameInstance() ? GetGameInstance()->GetSubsystem<UChessPuzzleSubsystem>() : nullptr;
+    FChessPuzzle Puzzle;
+    FChessPosition StartPosition;
+    if (!PuzzleSubsystem || !PuzzleSubsystem->PickPuzzle(MinRating, MaxRating, Theme, Puzzle) || !StartPosition.SetFromFen(Puzzle.Fen))
+    {
+        UE_LOG(LogTemp, Warning, TEXT("No puzzle rated %d - %d in %s"), MinRating, MaxRating, *FChessPuzzleDatabase::GetDefaultFilename());
+        return;
+    }
+
+    FChessPuzzleAttempt& Attempt = Attempts.FindOrAdd(ChessBoard);
+    Attempt.Solver = Solver;
+    Attempt.Puzzle = MoveTemp(Puzzle);
+    Attempt.Position = StartPosition;
+    Attempt.Ply = 0;
+    Attempt.HandledSequence = 0;
+    Attempt.PuzzleNumber++;
+    Attempt.Mistakes = 0;
+
+    // The solver always plays the side to move, the other side is left empty and answered from the solution
+    ChessBoard->StartChessGame(StartPosition.bWhiteToMove ? Solver : nullptr, StartPosition.bWhiteToMove ? nullptr : Solver, Attempt.Puzzle.Fen);
+    ChessBoard->UpdatePlayersUI();
+}
+
+void AChessPuzzleGameMode::EndTurn(AChessBoard* ChessBoard)
+{
+    Super::EndTurn(ChessBoard);
+
+    FChessPuzzleAttempt* Attempt = ChessBoard ? Attempts.Find(ChessBoard) : nullptr;
+    if (!Attempt || ChessBoard->GetMoveSequence() == Attempt->HandledSequence || !Attempt->Puzzle.Solution.IsValidIndex(Attempt->Ply)) return;
+    Attempt->HandledSequence = ChessBoard->GetMoveSequence();
+
+    FChessPosition Expected = Attempt->Position;
+    Expected.ApplyMove(Attempt->Puzzle.Solution[Attempt->Ply]);
+
+    // Any mate is as good as the stored one, otherwise only the stored move counts
+    const FChessPosition& Played = ChessBoard->GetPosition();
+    FChessMoveList Replies;
+    FChessMoveGenerator::GenerateLegalMoves(Played, Replies);
+    const bool bMate = Replies.IsEmpty() && FChessMoveGenerator::IsInCheck(Played);
+
+    if (!bMate && Played.ComputeHash() != Expected.ComputeHash())
+    {
+        Attempt->Mistakes++;
+        ShowAttemptPosition(ChessBoard, Attempt->PuzzleNumber, ReplyDelay);
+        return;
+    }
+
+    if (bMate || Attempt->Ply + 1 >= Attempt->Puzzle.Solution.Num())
+    {
+        UE_LOG(LogTemp, Display, TEXT("Puzzle rated %d solved on match %d with %d mistakes"), Attempt->Puzzle.Rating, ChessBoard->GetMatchId(), Attempt->Mistakes);
+        Attempt->Ply = Attempt->Puzzle.Solution.Num();
+
+        FTimerHandle TimerHandle;
+        TWeakObjectPtr<AChessBoard> WeakChessBoard = ChessBoard;
+        TWeakObjectPtr<AChessPlayer> WeakSolver = Attempt->Solver;
+        const int32 PuzzleNumber = Attempt->PuzzleNumber;
+        GetWorld()->GetTimerManager().SetTimer(TimerHandle, [this, WeakChessBoard, WeakSolver, PuzzleNumber]()
+        {
+            const FChessPuzzleAttempt* SolvedAttempt = WeakChessBoard.IsValid() ? Attempts.Find(WeakChessBoard.Get()) : nullptr;
+            if (SolvedAttempt && SolvedAttempt->PuzzleNumber == PuzzleNumber) StartPuzzle(WeakChessBoard.Get(), WeakSolver.Get());
+        }, NextPuzzleDelay, false);
+        return;
+    }
+
+    // Right move, the reply is played for the empty side once the solver has seen theirs land
+    Attempt->Position = Expected;
+    Attempt->Position.ApplyMove(Attempt->Puzzle.Solution[Attempt->Ply + 1]);
+    Attempt->Ply += 2;
+    ShowAttemptPosition(ChessBoard, Attempt->PuzzleNumber, ReplyDelay);
+}
+
+void AChessPuzzleGameMode::ShowAttemptPosition(AChessBoard* ChessBoard, int32 PuzzleNumber, float Delay)
+{
+    FTimerHandle TimerHandle;
+    TWeakObjectPtr<AChessBoard> WeakChessBoard = ChessBoard;
+    GetWorld()->GetTimerManager().SetTimer(TimerHandle, [this, WeakChessBoard, PuzzleNumber]()
+    {
+        AChessBoard* PuzzleBoard = WeakChessBoard.Get();
+        const FChessPuzzleAttempt* Attempt = PuzzleBoard ? Attempts.Find(PuzzleBoard) : nullptr;
+        if (!Attempt || Attempt->PuzzleNumber != PuzzleNumber) return;
+
+        // Set up through FEN like any other position, the board rebuilds checks, pins and the pieces' moves from it
+        PuzzleBoard->LoadFen(Attempt->Position.ToFen());
+        PuzzleBoard->UpdatePlayersUI();
+    }, Delay, false);
+}
@@ -0,0 +1,175 @@
+// Copyright (©) 2024, Van Phan. All rights reserved.
+
+
+#include "GameModes/ChessReplayGameMode.h"
+#include "Actors/ChessBoard.h"
+#include "Actors/BoardSquare.h"
+#include "Actors/BaseChessPiece.h"
+#include "PlayerControllers/ChessPlayer.h"
+#include "PlayerStates/ChessPlayerState.h"
+#include "Kismet/GameplayStatics.h"
+#include "EngineUtils.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+
+AChessReplayGameMode::AChessReplayGameMode()
+{
+    PrimaryActorTick.bCanEverTick = true;
+}
+
+void AChessReplayGameMode::InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage)
+{
+    Super::InitGame(MapName, Options, ErrorMessage);
+
+    // A bare file name is looked up in Saved/Replays, same place the boards record to
+    ReplayFilename = UGameplayStatics::ParseOption(Options, TEXT("Replay"));
+    if (ReplayFilename.IsEmpty()) ReplayFilename = FindNewestReplay();
+    else if (FPaths::IsRelative(ReplayFilename)) ReplayFilename = FPaths::ProjectSavedDir() / TEXT("Replays") / ReplayFilename;
+}
+
+void AChessReplayGameMode::StartPlay()
+{
+    Super::StartPlay();
+
+    // Every actor has begun play by now, so the board has its pieces
+    TActorIterator<AChessBoard> It(GetWorld());
+    ReplayBoard = It ? *It : nullptr;
+    if (!ReplayBoard)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Replay needs a chess board in the level"));
+        return;
+    }
+
+    // Local players logged in before the level began play
+    for (FConstPlayerControllerIterator Iterator = GetWorld()->GetPlayerControllerIterator(); Iterator; ++Iterator)
+    {
+        if (APlayerController* Viewer = Iterator->Get()) AddViewer(Viewer);
+    }
+
+    if (ReplayFilename.IsEmpty() || !Reader.Open(ReplayFilename))
+    {
+        UE_LOG(LogTemp, Warning, TEXT("No replay to play back"));
+        return;
+    }
+
+    UE_LOG(LogTemp, Display, TEXT("Playing back %s, %d moves"), *ReplayFilename, Reader.GetNumPlies());
+    SeekToPly(0);
+}
+
+void AChessReplayGameMode::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    Reader.Close();
+    Super::EndPlay(EndPlayReason);
+}
+
+void AChessReplayGameMode::PostLogin(APlayerController* NewPlayer)
+{
+    // Never queued for a match, viewers only ever watch
+    if (ReplayBoard) AddViewer(NewPlayer);
+}
+
+void AChessReplayGameMode::AddViewer(APlayerController* Viewer)
+{
+    AChessPlayer* ChessPlayer = Cast<AChessPlayer>(Viewer);
+    if (!ChessPlayer || ChessPlayer->GetPawn()) return;
+
+    if (AChessPlayerState* ChessPlayerState = ChessPlayer->GetPlayerState<AChessPlayerState>())
+    {
+        ChessPlayerState->bIsSpectator = true;
+        ChessPlayerState->ChessBoard = ReplayBoard;
+    }
+    SpawnObservationPawn(ChessPlayer, ReplayBoard);
+}
+
+void AChessReplayGameMode::Tick(float DeltaSeconds)
+{
+    Super::Tick(DeltaSeconds);
+    if (!ReplayBoard || !Reader.IsOpen() || bPaused) return;
+
+    // Clock runs between the start of the game and its last move
+    const int32 NumPlies = Reader.GetNumPlies();
+    const double EndTimeMs = NumPlies > 0 ? Reader.GetClockMs(NumPlies - 1) : 0.0;
+    PlaybackTimeMs = FMath::Clamp(PlaybackTimeMs + DeltaSeconds * 1000.0 * PlaybackSpeed, 0.0, EndTimeMs);
+
+    int32 TargetPly = CurrentPly;
+    while (TargetPly < NumPlies && Reader.GetClockMs(TargetPly) <= PlaybackTimeMs) TargetPly++;
+    while (TargetPly > 0 && Reader.GetClockMs(TargetPly - 1) > PlaybackTimeMs) TargetPly--;
+    if (TargetPly == CurrentPly) return;
+
+    // Stepping keeps the moves visible, going backwards or far ahead snaps from a snapshot instead
+    if (TargetPly < CurrentPly || TargetPly - CurrentPly > Reader.GetHeader().SnapshotInterval)
+    {
+        SeekToPly(TargetPly);
+        return;
+    }
+    while (CurrentPly < TargetPly) StepForward();
+}
+
+void AChessReplayGameMode::ReplaySpeed(float NewSpeed)
+{
+    const float Direction = NewSpeed < 0.0f ? -1.0f : 1.0f;
+    PlaybackSpeed = Direction * FMath::Clamp(FMath::Abs(NewSpeed), 1.0f, 64.0f);
+    bPaused = false;
+}
+
+void AChessReplayGameMode::ReplaySeek(int32 Ply)
+{
+    if (!ReplayBoard || !Reader.IsOpen()) return;
+
+    SeekToPly(FMath::Clamp(Ply, 0, Reader.GetNumPlies()));
+    PlaybackTimeMs = CurrentPly > 0 ? Reader.GetClockMs(CurrentPly - 1) : 0.0;
+}
+
+void AChessReplayGameMode::ReplayPause()
+{
+    bPaused = !bPaused;
+}
+
+void AChessReplayGameMode::SeekToPly(int32 Ply)
+{
+    FChessPosition SeekPosition;
+    if (!Reader.GetPositionAtPly(Ply, SeekPosition)) return;
+
+    CurrentPly = Ply;
+    ReplayBoard->ShowPosition(SeekPosition);
+    ReplayBoard->CurrentTeamTurn = SeekPosition.bWhiteToMove ? EChessTeam::White : EChessTeam::Black;
+    ReplayBoard->SpawnMissingPieces();
+}
+
+void AChessReplayGameMode::StepForward()
+{
+    const uint16 Move = Reader.GetMove(CurrentPly);
+    if (!ReplayBoard->ShowMove(Move))
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Replay move %d doesn't fit the board, snapping to it"), CurrentPly);
+        SeekToPly(CurrentPly + 1);
+        return;
+    }
+
+    CurrentPly++;
+    ReplayBoard->CurrentTeamTurn = ReplayBoard->GetPosition().bWhiteToMove ? EChessTeam::White : EChessTeam::Black;
+
+    // The board only lifts the pawn, the piece it became has to come from somewhere
+    if (ChessMove::GetPromotion(Move) != ChessPiece::None) ReplayBoard->SpawnMissingPieces();
+}
+
+FString AChessReplayGameMode::FindNewestReplay()
+{
+    const FString ReplayDirectory = FPaths::ProjectSavedDir() / TEXT("Replays");
+    TArray<FString> ReplayFiles;
+    IFileManager::Get().FindFiles(ReplayFiles, *(ReplayDirectory / TEXT("*.chessreplay")), true, false);
+
+    FString NewestReplay;
+    FDateTime NewestTime = FDateTime::MinValue();
+    for (const FString& ReplayFile : ReplayFiles)
+    {
+        const FString FullPath = ReplayDirectory / ReplayFile;
+        const FDateTime FileTime = IFileManager::Get().GetTimeStamp(*FullPath);
+        if (FileTime > NewestTime)
+        {
+            NewestTime = FileTime;
+            NewestReplay = FullPath;
+        }
+    }
+    return NewestReplay;
+}
@@ -0,0 +1,127 @@
+// Copyright (©) 2024, Van Phan. All rights reserved.
+
+
+#include "GameModes/ChessSimulGameMode.h"
+#include "Actors/ChessBoard.h"
+#include "Pawns/PlayablePawn.h"
+#include "PlayerControllers/ChessPlayer.h"
+#include "PlayerStates/ChessPlayerState.h"
+#include "Subsystems/ChessMatchSubsystem.h"
+#include "Networking/ChessReplicationGraph.h"
+#include "Engine/World.h"
+
+void AChessSimulGameMode::PlayerReady(AChessPlayer* Player)
+{
+    AChessPlayerState* ChessPlayerState = Player ? Player->GetPlayerState<AChessPlayerState>() : nullptr;
+    if (!ChessPlayerState || ChessPlayerState->bIsSpectator || Player == Exhibitor) return;
+
+    if (!Exhibitor)
+    {
+        Exhibitor = Player;
+        UE_LOG(LogTemp, Display, TEXT("%s is giving the simul"), *Player->GetName());
+        return;
+    }
+
+    // Every challenger gets a board of their own against the exhibitor, a finished one is given up for the new game
+    UChessMatchSubsystem* MatchSubsystem = GetWorld()->GetSubsystem<UChessMatchSubsystem>();
+    if (MatchSubsystem) MatchSubsystem->LeaveFinishedMatches(Player);
+    const int32 MatchId = MatchSubsystem ? MatchSubsystem->PairOnFreeBoard(Exhibitor, Player) : INDEX_NONE;
+    if (MatchId == INDEX_NONE)
+    {
+        UE_LOG(LogTemp, Display, TEXT("No free board in the simul for %s"), *Player->GetName());
+        return;
+    }
+    StartGame(MatchId);
+}
+
+void AChessSimulGameMode::Logout(AController* Exiting)
+{
+    if (Exiting && Exiting == Exhibitor)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("The simul exhibitor left, their boards are abandoned"));
+        Exhibitor = nullptr;
+    }
+    Super::Logout(Exiting);
+}
+
+AChessPlayer* AChessSimulGameMode::GetTravellingPlayer(const FChessMatch& Match) const
+{
+    // A new board must not pull the exhibitor away from the one in front of them
+    return Exhibitor;
+}
+
+void AChessSimulGameMode::MatchStarted(AChessBoard* ChessBoard)
+{
+    if (Exhibitor && ChessBoard && ChessBoard->GetWhitePlayer() == Exhibitor) MoveExhibitorToNextBoard();
+}
+
+void AChessSimulGameMode::MatchEnded(AChessBoard* ChessBoard)
+{
+    // The exhibitor walks on from a finished board straight away, the challenger stays to see the result
+    UChessMatchSubsystem* MatchSubsystem = GetWorld()->GetSubsystem<UChessMatchSubsystem>();
+    if (!Exhibitor || !MatchSubsystem || !ChessBoard || ChessBoard->GetWhitePlayer() != Exhibitor) return;
+
+    MatchSubsystem->LeaveMatch(Exhibitor, ChessBoard->GetMatchId());
+    MoveExhibitorToNextBoard();
+}
+
+void AChessSimulGameMode::EndTurn(AChessBoard* ChessBoard)
+{
+    Super::EndTurn(ChessBoard);
+
+    // Either side moving on any of the exhibitor's boards can change where they are needed next
+    if (Exhibitor && ChessBoard && ChessBoard->GetWhitePlayer() == Exhibitor) MoveExhibitorToNextBoard();
+}
+
+void AChessSimulGameMode::MoveExhibitorToNextBoard()
+{
+    UChessMatchSubsystem* MatchSubsystem = GetWorld()->GetSubsystem<UChessMatchSubsystem>();
+    if (!MatchSubsystem) return;
+
+    TArray<FChessMatch*> ExhibitorMatches;
+    MatchSubsystem->GetMatchesForPlayer(Exhibitor, ExhibitorMatches);
+    ExhibitorMatches.Sort([](const FChessMatch& A, const FChessMatch& B) { return A.MatchId < B.MatchId; });
+
+    const APlayablePawn* CurrentPawn = Cast<APlayablePawn>(Exhibitor->GetPawn());
+    const AChessBoard* CurrentBoard = CurrentPawn ? CurrentPawn->GetChessBoard() : nullptr;
+    auto IsWaitingOnExhibitor = [](const FChessMatch* Match)
+    {
+        // Time and players leaving end games too, only the board's end game state knows about all of them
+        return Match->Board && Match->Board->CurrentEndGameState == EEndGameState::EndGameStateNone && Match->Board->CurrentTeamTurn == EChessTeam::White;
+    };
+
+    // The next waiting board round the ring from the current one, wrapping back to the first
+    FChessMatch* NextMatch = nullptr;
+    const int32 CurrentMatchId = CurrentBoard ? CurrentBoard->GetMatchId() : INDEX_NONE;
+    for (FChessMatch* Match : ExhibitorMatches)
+    {
+        if (!IsWaitingOnExhibitor(Match)) continue;
+        if (Match->Board == CurrentBoard) return;
+        if (Match->MatchId > CurrentMatchId)
+        {
+            NextMatch = Match;
+            break;
+        }
+        if (!NextMatch) NextMatch = Match;
+    }
+
+    if (NextMatch) MoveExhibitorTo(NextMatch->Board);
+}
+
+void AChessSimulGameMode::MoveExhibitorTo(AChessBoard* ChessBoard)
+{
+    APlayablePawn* PlayablePawn = ChessBoard ? ChessBoard->GetPlayablePawn(EChessTeam::White) : nullptr;
+    if (!PlayablePawn || Exhibitor->GetPawn() == PlayablePawn) return;
+
+    const bool bFirstBoard = !Cast<APlayablePawn>(Exhibitor->GetPawn());
+    Exhibitor->Possess(PlayablePawn);
+
+    // The HUD and relevancy follow the board in front of them, the first board also starts the HUD
+    AChessPlayerState* ChessPlayerState = Exhibitor->GetPlayerState<AChessPlayerState>();
+    if (!ChessPlayerState) return;
+    ChessPlayerState->ChessTeam = EChessTeam::White;
+    ChessPlayerState->ChessBoard = ChessBoard;
+    UChessReplicationGraph::NotifyMatchesChanged(GetWorld());
+    if (bFirstBoard) Exhibitor->Client_StartGame(EChessTeam::White);
+    ChessBoard->UpdatePlayersUI();
+}
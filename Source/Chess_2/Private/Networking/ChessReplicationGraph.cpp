@@ -0,0 +1,187 @@
+// Copyright (©) 2024, Van Phan. All rights reserved.
+
+
+#include "Networking/ChessReplicationGraph.h"
+#include "Actors/ChessBoard.h"
+#include "Actors/BoardSquare.h"
+#include "Actors/BaseChessPiece.h"
+#include "Actors/ChessSpectatorFeed.h"
+#include "Pawns/PlayablePawn.h"
+#include "PlayerStates/ChessPlayerState.h"
+#include "GameFramework/PlayerController.h"
+#include "Engine/NetDriver.h"
+#include "Chess_2.h"
+
+UChessReplicationGraphNode_Matches::UChessReplicationGraphNode_Matches()
+{
+	bRequiresPrepareForReplicationCall = true;
+}
+
+void UChessReplicationGraphNode_Matches::NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo)
+{
+	MatchActors.ConditionalAdd(ActorInfo.Actor);
+	bMatchListsDirty = true;
+}
+
+bool UChessReplicationGraphNode_Matches::NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound)
+{
+	const bool bRemoved = MatchActors.RemoveFast(ActorInfo.Actor);
+	bMatchListsDirty |= bRemoved;
+	return bRemoved;
+}
+
+void UChessReplicationGraphNode_Matches::NotifyResetAllNetworkActors()
+{
+	MatchActors.Reset();
+	MatchLists.Reset();
+	bMatchListsDirty = true;
+}
+
+void UChessReplicationGraphNode_Matches::PrepareForReplication()
+{
+	// Actors coming and going dirty the lists here, boards and players changing hands are reported through NotifyMatchesChanged
+	if (bMatchListsDirty) RebuildMatchLists();
+}
+
+void UChessReplicationGraphNode_Matches::RebuildMatchLists()
+{
+	for (TPair<TObjectKey<AChessBoard>, FChessMatchReplicationLists>& Match : MatchLists)
+	{
+		Match.Value.PlayerActors.Reset();
+		Match.Value.SpectatorActors.Reset();
+	}
+
+	for (AActor* Actor : MatchActors)
+	{
+		// Spectators and unpaired players belong to no match, they're sorted in when they're paired
+		AChessBoard* Board = FindBoardForActor(Actor);
+		if (!Board) continue;
+
+		FChessMatchReplicationLists& Lists = MatchLists.FindOrAdd(Board);
+		if (Actor->IsA<AChessSpectatorFeed>()) Lists.SpectatorActors.Add(Actor);
+		else Lists.PlayerActors.Add(Actor);
+	}
+
+	bMatchListsDirty = false;
+}
+
+AChessBoard* UChessReplicationGraphNode_Matches::FindBoardForActor(const AActor* Actor)
+{
+	if (const AChessBoard* Board = Cast<AChessBoard>(Actor)) return const_cast<AChessBoard*>(Board);
+	if (const ABoardSquare* Square = Cast<ABoardSquare>(Actor)) return Square->GetOwningBoard();
+	if (const ABaseChessPiece* Piece = Cast<ABaseChessPiece>(Actor)) return Piece->GetChessBoard();
+	if (const APlayablePawn* PlayablePawn = Cast<APlayablePawn>(Actor)) return PlayablePawn->GetChessBoard();
+	if (const AChessSpectatorFeed* SpectatorFeed = Cast<AChessSpectatorFeed>(Actor)) return SpectatorFeed->GetBoard();
+	if (const AChessPlayerState* ChessPlayerState = Cast<AChessPlayerState>(Actor)) return ChessPlayerState->bIsSpectator ? nullptr : ChessPlayerState->ChessBoard;
+	return nullptr;
+}
+
+void UChessReplicationGraphNode_Matches::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	if (Params.Viewers.IsEmpty()) return;
+
+	const APlayerController* Viewer = Cast<APlayerController>(Params.Viewers[0].InViewer);
+	const AChessPlayerState* ViewerState = Viewer ? Viewer->GetPlayerState<AChessPlayerState>() : nullptr;
+	if (!ViewerState || !ViewerState->ChessBoard) return; // Not paired yet, nothing to play
+
+	FChessMatchReplicationLists* Lists = MatchLists.Find(ViewerState->ChessBoard);
+	if (!Lists) return;
+
+	if (!ViewerState->bIsSpectator)
+	{
+		Params.OutGatheredReplicationLists.AddReplicationActorList(Lists->PlayerActors);
+		return;
+	}
+
+	// Each bucket of spectators is only served on its own frame
+	const uint32 NumBuckets = (uint32)FMath::Max(CVarChessSpectatorBuckets.GetValueOnGameThread(), 1);
+	if ((Params.ReplicationFrameNum + (uint32)Params.ConnectionManager.ConnectionOrderNum) % NumBuckets != 0) return;
+	Params.OutGatheredReplicationLists.AddReplicationActorList(Lists->SpectatorActors);
+}
+
+void UChessReplicationGraphNode_AlwaysRelevantForConnection::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	ReplicationActorList.Reset();
+	for (const FNetViewer& Viewer : Params.Viewers)
+	{
+		AController* ViewerController = Viewer.InViewer;
+		AActor* ViewTarget = Viewer.ViewTarget;
+		if (ViewerController) ReplicationActorList.ConditionalAdd(ViewerController);
+		if (ViewTarget) ReplicationActorList.ConditionalAdd(ViewTarget);
+
+		if (const APlayerController* PlayerController = Cast<APlayerController>(ViewerController))
+		{
+			if (PlayerController->GetPawn()) ReplicationActorList.ConditionalAdd(PlayerController->GetPawn());
+			if (PlayerController->PlayerState) ReplicationActorList.ConditionalAdd(PlayerController->PlayerState);
+		}
+	}
+
+	Super::GatherActorListsForConnection(Params);
+}
+
+void UChessReplicationGraph::NotifyMatchesChanged(const UWorld* World)
+{
+	const UNetDriver* NetDriver = World ? World->GetNetDriver() : nullptr;
+	const UChessReplicationGraph* Graph = NetDriver ? Cast<UChessReplicationGraph>(NetDriver->GetReplicationDriver()) : nullptr;
+	if (Graph && Graph->MatchesNode) Graph->MatchesNode->MarkMatchListsDirty();
+}
+
+void UChessReplicationGraph::InitGlobalActorClassSettings()
+{
+	Super::InitGlobalActorClassSettings();
+
+	// Anything without its own entry replicates at the rate it asks for
+	FClassReplicationInfo DefaultInfo;
+	DefaultInfo.ReplicationPeriodFrame = GetReplicationPeriodFrameForFrequency(GetDefault<AActor>()->NetUpdateFrequency);
+	GlobalActorReplicationInfoMap.SetClassInfo(AActor::StaticClass(), DefaultInfo);
+
+	// Spectators skip frames between their bucket's turns, keep the feed's channel open through the gap
+	FClassReplicationInfo SpectatorFeedInfo;
+	SpectatorFeedInfo.ReplicationPeriodFrame = GetReplicationPeriodFrameForFrequency(GetDefault<AChessSpectatorFeed>()->NetUpdateFrequency);
+	SpectatorFeedInfo.ActorChannelFrameTimeout = MAX_uint8;
+	GlobalActorReplicationInfoMap.SetClassInfo(AChessSpectatorFeed::StaticClass(), SpectatorFeedInfo);
+
+	// Hand updates are multicast, only send them where the pawn is already replicating rather than opening it up for spectators
+	RPC_Multicast_OpenChannelForClass.Set(APlayablePawn::StaticClass(), false);
+}
+
+void UChessReplicationGraph::InitGlobalGraphNodes()
+{
+	AlwaysRelevantNode = CreateNewNode<UReplicationGraphNode_ActorList>();
+	AddGlobalGraphNode(AlwaysRelevantNode);
+
+	MatchesNode = CreateNewNode<UChessReplicationGraphNode_Matches>();
+	AddGlobalGraphNode(MatchesNode);
+}
+
+void UChessReplicationGraph::InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection)
+{
+	Super::InitConnectionGraphNodes(RepGraphConnection);
+
+	UChessReplicationGraphNode_AlwaysRelevantForConnection* AlwaysRelevantForConnectionNode = CreateNewNode<UChessReplicationGraphNode_AlwaysRelevantForConnection>();
+	AddConnectionGraphNode(AlwaysRelevantForConnectionNode, RepGraphConnection);
+}
+
+void UChessReplicationGraph::RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo)
+{
+	if (IsMatchActor(ActorInfo.Actor)) MatchesNode->NotifyAddNetworkActor(ActorInfo);
+	else if (!IsConnectionActor(ActorInfo.Actor)) AlwaysRelevantNode->NotifyAddNetworkActor(ActorInfo);
+}
+
+void UChessReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo)
+{
+	if (IsMatchActor(ActorInfo.Actor)) MatchesNode->NotifyRemoveNetworkActor(ActorInfo);
+	else if (!IsConnectionActor(ActorInfo.Actor)) AlwaysRelevantNode->NotifyRemoveNetworkActor(ActorInfo);
+}
+
+bool UChessReplicationGraph::IsMatchActor(const AActor* Actor)
+{
+	return Actor->IsA<AChessBoard>() || Actor->IsA<ABoardSquare>() || Actor->IsA<ABaseChessPiece>() || Actor->IsA<APlayablePawn>()
+		|| Actor->IsA<AChessSpectatorFeed>() || Actor->IsA<AChessPlayerState>();
+}
+
+bool UChessReplicationGraph::IsConnectionActor(const AActor* Actor)
+{
+	// Spectator pawns and player states would otherwise go to every connection, which is what stops spectators scaling
+	return Actor->bOnlyRelevantToOwner || Actor->IsA<APlayerController>() || Actor->IsA<APawn>() || Actor->IsA<APlayerState>();
+}
@@ -0,0 +1,185 @@
+// Copyright (©) 2024, Van Phan. All rights reserved.
+
+
+#include "Subsystems/ChessAnalysisSubsystem.h"
+#include "Actors/ChessBoard.h"
+#include "Async/Async.h"
+#include "Misc/QueuedThreadPool.h"
+#include "Chess_2.h"
+
+void UChessAnalysisSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+    Super::Initialize(Collection);
+
+    // Kept below the game's own threads, searching should never cost a frame. Two at least, the open ended
+    // analysis holds one thread for as long as it runs and hints mustn't queue behind it
+    const int32 NumThreads = FMath::Clamp(FPlatformMisc::NumberOfCoresIncludingHyperthreads() / 4, 2, 4);
+    SearchThreadPool = FQueuedThreadPool::Allocate();
+    if (!SearchThreadPool->Create(NumThreads, 256 * 1024, TPri_BelowNormal, TEXT("ChessSearchPool")))
+    {
+        delete SearchThreadPool;
+        SearchThreadPool = nullptr;
+    }
+}
+
+void UChessAnalysisSubsystem::Deinitialize()
+{
+    StopAnalysis();
+    for (const TPair<uint64, TSharedPtr<FHintJob, ESPMode::ThreadSafe>>& Hint : PendingHints) Hint.Value->bStop = true;
+    PendingHints.Empty();
+    if (SearchThreadPool)
+    {
+        SearchThreadPool->Destroy(); // Waits for the searches, which have just been told to stop
+        delete SearchThreadPool;
+        SearchThreadPool = nullptr;
+    }
+    Super::Deinitialize();
+}
+
+bool UChessAnalysisSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+    return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UChessAnalysisSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UChessAnalysisSubsystem, STATGROUP_Chess);
+}
+
+void UChessAnalysisSubsystem::StartAnalysis(const AChessBoard* Board, int32 NumLines)
+{
+    if (!Board || !SearchThreadPool) return;
+
+    const int32 NewLines = FMath::Max(NumLines, 1);
+    if (AnalysedBoard == Board && AnalysedLines == NewLines) return;
+
+    AnalysedBoard = Board;
+    AnalysedLines = NewLines;
+    AnalysedHash = Board->GetPosition().ComputeHash();
+    RestartJob(Board->GetPosition());
+}
+
+void UChessAnalysisSubsystem::StopAnalysis()
+{
+    AnalysedBoard.Reset();
+    StopJob();
+}
+
+void UChessAnalysisSubsystem::RequestHint(const AChessBoard* Board, float TimeBudgetSeconds)
+{
+    if (!Board || !SearchThreadPool) return;
+
+    const uint64 Hash = Board->GetPosition().ComputeHash();
+    if (const uint16* CachedMove = HintCache.Find(Hash))
+    {
+        OnHintReady.Broadcast(Hash, *CachedMove);
+        return;
+    }
+    if (PendingHints.Contains(Hash)) return;
+
+    TSharedPtr<FHintJob, ESPMode::ThreadSafe> Job = MakeShared<FHintJob, ESPMode::ThreadSafe>();
+    Job->Position = Board->GetPosition();
+    PendingHints.Add(Hash, Job);
+
+    // The budget runs from the request, time spent waiting for a free thread comes out of the search
+    const double Deadline = FPlatformTime::Seconds() + FMath::Max(TimeBudgetSeconds, 0.05f);
+    AsyncPool(*SearchThreadPool, [Job, Deadline]()
+    {
+        FChessSearchLimits Limits;
+        Limits.TimeLimitSeconds = Deadline - FPlatformTime::Seconds();
+        if (Limits.TimeLimitSeconds <= 0.0)
+        {
+            // Already late, a one ply search still gives a legal move quickly
+            Limits.TimeLimitSeconds = 0.0;
+            Limits.MaxDepth = 1;
+        }
+
+        FChessSearch Search;
+        Job->Move = Search.Search(Job->Position, Limits, &Job->bStop).BestMove;
+        Job->bDone = true;
+    }, nullptr, EQueuedWorkPriority::Low);
+}
+
+void UChessAnalysisSubsystem::CollectHints()
+{
+    // Broadcast after the walk, listeners are free to ask for another hint
+    TArray<TPair<uint64, uint16>, TInlineAllocator<4>> FinishedHints;
+    for (auto It = PendingHints.CreateIterator(); It; ++It)
+    {
+        if (!It.Value()->bDone) continue;
+        FinishedHints.Emplace(It.Key(), It.Value()->Move);
+        It.RemoveCurrent();
+    }
+
+    for (const TPair<uint64, uint16>& Hint : FinishedHints)
+    {
+        if (HintCache.Num() >= MaxCachedHints) HintCache.Empty();
+        HintCache.Add(Hint.Key, Hint.Value);
+        OnHintReady.Broadcast(Hint.Key, Hint.Value);
+    }
+}
+
+void UChessAnalysisSubsystem::Tick(float DeltaTime)
+{
+    Super::Tick(DeltaTime);
+    if (PendingHints.Num() > 0) CollectHints();
+    if (!CurrentJob) return;
+
+    const AChessBoard* Board = AnalysedBoard.Get();
+    if (!Board)
+    {
+        StopAnalysis();
+        return;
+    }
+
+    // Moves are noticed by hash, the board doesn't need to know anyone is analysing it
+    const uint64 Hash = Board->GetPosition().ComputeHash();
+    if (Hash != AnalysedHash)
+    {
+        AnalysedHash = Hash;
+        RestartJob(Board->GetPosition());
+        return;
+    }
+
+    TimeSinceUpdate += DeltaTime;
+    if (TimeSinceUpdate < UpdateInterval) return;
+
+    FChessSearchResult Result;
+    {
+        FScopeLock Lock(&CurrentJob->ResultLock);
+        if (!CurrentJob->bHasNewResult) return;
+        CurrentJob->bHasNewResult = false;
+        Result = CurrentJob->LatestResult;
+    }
+    TimeSinceUpdate = 0.0f;
+    OnAnalysisUpdated.Broadcast(CurrentJob->Position, Result);
+}
+
+void UChessAnalysisSubsystem::RestartJob(const FChessPosition& Position)
+{
+    StopJob();
+
+    TSharedPtr<FAnalysisJob, ESPMode::ThreadSafe> Job = MakeShared<FAnalysisJob, ESPMode::ThreadSafe>();
+    Job->Position = Position;
+    CurrentJob = Job;
+    TimeSinceUpdate = UpdateInterval; // The first finished depth is shown straight away
+
+    FChessSearchLimits Limits;
+    Limits.MultiPV = AnalysedLines;
+    AsyncPool(*SearchThreadPool, [Job, Limits]()
+    {
+        FChessSearch Search;
+        Search.Search(Job->Position, Limits, &Job->bStop, [&Job](const FChessSearchResult& Result)
+        {
+            FScopeLock Lock(&Job->ResultLock);
+            Job->LatestResult = Result;
+            Job->bHasNewResult = true;
+        });
+    }, nullptr, EQueuedWorkPriority::Normal);
+}
+
+void UChessAnalysisSubsystem::StopJob()
+{
+    if (CurrentJob) CurrentJob->bStop = true;
+    CurrentJob.Reset();
+}
@@ -0,0 +1,205 @@
+// Copyright (©) 2024, Van Phan. All rights reserved.
+
+
+#include "Subsystems/ChessMatchSubsystem.h"
+#include "Actors/ChessBoard.h"
+#include "PlayerControllers/ChessPlayer.h"
+#include "PlayerStates/ChessPlayerState.h"
+#include "Pawns/PlayablePawn.h"
+
+int32 UChessMatchSubsystem::RegisterBoard(AChessBoard* Board)
+{
+    if (!Board) return INDEX_NONE;
+
+    for (const TPair<int32, FChessMatch>& Match : Matches)
+    {
+        if (Match.Value.Board == Board) return Match.Key;
+    }
+
+    FChessMatch NewMatch;
+    NewMatch.MatchId = NextMatchId++;
+    NewMatch.Board = Board;
+    Matches.Add(NewMatch.MatchId, NewMatch);
+
+    // Players may have queued before any board was free, their game starts once this board is ready
+    PairWaitingPlayers();
+    return NewMatch.MatchId;
+}
+
+void UChessMatchSubsystem::UnregisterBoard(AChessBoard* Board)
+{
+    if (!Board) return;
+
+    FChessMatch* Match = FindMatch(Board->GetMatchId());
+    if (!Match || Match->Board != Board) return;
+
+    if (Match->WhitePlayer) PlayerMatchIds.RemoveSingle(Match->WhitePlayer, Match->MatchId);
+    if (Match->BlackPlayer) PlayerMatchIds.RemoveSingle(Match->BlackPlayer, Match->MatchId);
+    Matches.Remove(Board->GetMatchId());
+}
+
+int32 UChessMatchSubsystem::QueuePlayer(AChessPlayer* Player)
+{
+    LeaveFinishedMatches(Player);
+    if (!Player || PlayerMatchIds.Contains(Player)) return INDEX_NONE;
+    WaitingPlayers.AddUnique(Player);
+    if (WaitingPlayers.Num() < 2) return INDEX_NONE;
+
+    // Coin flip for colours, same as a single match always did
+    const bool bFirstIsWhite = FMath::RandRange(0, 1) == 1;
+    const int32 MatchId = PairOnFreeBoard(WaitingPlayers[bFirstIsWhite ? 0 : 1], WaitingPlayers[bFirstIsWhite ? 1 : 0]);
+    if (MatchId == INDEX_NONE)
+    {
+        UE_LOG(LogTemp, Display, TEXT("No free chess board, %d players waiting"), WaitingPlayers.Num());
+        return INDEX_NONE;
+    }
+
+    WaitingPlayers.RemoveAt(0, 2);
+    return MatchId;
+}
+
+int32 UChessMatchSubsystem::PairOnFreeBoard(AChessPlayer* WhitePlayer, AChessPlayer* BlackPlayer)
+{
+    if (!WhitePlayer || !BlackPlayer) return INDEX_NONE;
+
+    for (TPair<int32, FChessMatch>& Match : Matches)
+    {
+        if (!Match.Value.Board || Match.Value.HasPlayers()) continue;
+
+        Match.Value.WhitePlayer = WhitePlayer;
+        Match.Value.BlackPlayer = BlackPlayer;
+        PlayerMatchIds.Add(WhitePlayer, Match.Key);
+        PlayerMatchIds.Add(BlackPlayer, Match.Key);
+        return Match.Key;
+    }
+    return INDEX_NONE;
+}
+
+void UChessMatchSubsystem::RemovePlayer(AChessPlayer* Player)
+{
+    if (!Player) return;
+
+    WaitingPlayers.Remove(Player);
+
+    // Every match they were in is over, their opponents win
+    TArray<int32, TInlineAllocator<8>> MatchIds;
+    PlayerMatchIds.MultiFind(Player, MatchIds);
+    for (int32 MatchId : MatchIds) LeaveMatch(Player, MatchId);
+}
+
+void UChessMatchSubsystem::LeaveMatch(AChessPlayer* Player, int32 MatchId)
+{
+    FChessMatch* Match = Matches.Find(MatchId);
+    if (!Player || !Match || (Match->WhitePlayer != Player && Match->BlackPlayer != Player)) return;
+
+    if (Match->Board) Match->Board->HandlePlayerLeft(Player);
+    if (Match->WhitePlayer == Player) Match->WhitePlayer = nullptr;
+    if (Match->BlackPlayer == Player) Match->BlackPlayer = nullptr;
+    PlayerMatchIds.RemoveSingle(Player, MatchId);
+
+    // Their HUD and relevancy shouldn't follow a board someone else may be paired onto
+    AChessPlayerState* ChessPlayerState = Player->GetPlayerState<AChessPlayerState>();
+    if (ChessPlayerState && ChessPlayerState->ChessBoard == Match->Board) ChessPlayerState->ChessBoard = nullptr;
+
+    if (!Match->HasPlayers()) PairWaitingPlayers();
+}
+
+void UChessMatchSubsystem::LeaveFinishedMatches(AChessPlayer* Player)
+{
+    TArray<int32, TInlineAllocator<8>> MatchIds;
+    if (Player) PlayerMatchIds.MultiFind(Player, MatchIds);
+    for (int32 MatchId : MatchIds)
+    {
+        const FChessMatch* Match = Matches.Find(MatchId);
+        if (Match && Match->Board && Match->Board->CurrentEndGameState != EEndGameState::EndGameStateNone) LeaveMatch(Player, MatchId);
+    }
+}
+
+void UChessMatchSubsystem::PairWaitingPlayers()
+{
+    while (WaitingPlayers.Num() >= 2)
+    {
+        const bool bFirstIsWhite = FMath::RandRange(0, 1) == 1;
+        const int32 MatchId = PairOnFreeBoard(WaitingPlayers[bFirstIsWhite ? 0 : 1], WaitingPlayers[bFirstIsWhite ? 1 : 0]);
+        if (MatchId == INDEX_NONE) return;
+
+        WaitingPlayers.RemoveAt(0, 2);
+        OnMatchPaired.Broadcast(MatchId);
+    }
+}
+
+int32 UChessMatchSubsystem::StartSoloMatch(AChessPlayer* Player)
+{
+    if (!Player) return INDEX_NONE;
+    if (const int32* MatchId = PlayerMatchIds.Find(Player)) return *MatchId;
+
+    for (TPair<int32, FChessMatch>& Match : Matches)
+    {
+        if (!Match.Value.Board || Match.Value.HasPlayers()) continue;
+
+        // Held in the white slot only to mark the board as taken, the game mode decides which side they play
+        WaitingPlayers.Remove(Player);
+        Match.Value.WhitePlayer = Player;
+        PlayerMatchIds.Add(Player, Match.Key);
+        return Match.Key;
+    }
+
+    UE_LOG(LogTemp, Display, TEXT("No free chess board for a solo match"));
+    return INDEX_NONE;
+}
+
+FChessMatch* UChessMatchSubsystem::FindMatch(int32 MatchId)
+{
+    return Matches.Find(MatchId);
+}
+
+FChessMatch* UChessMatchSubsystem::FindMatchForPlayer(const AController* Player)
+{
+    if (!Player) return nullptr;
+
+    TArray<int32, TInlineAllocator<8>> MatchIds;
+    PlayerMatchIds.MultiFind(Player, MatchIds, true);
+    if (MatchIds.IsEmpty()) return nullptr;
+
+    // With several boards the player acts on whichever one their pawn stands at
+    const APlayablePawn* PlayablePawn = Cast<APlayablePawn>(Player->GetPawn());
+    for (int32 MatchId : MatchIds)
+    {
+        FChessMatch* Match = Matches.Find(MatchId);
+        if (Match && PlayablePawn && Match->Board == PlayablePawn->GetChessBoard()) return Match;
+    }
+    return Matches.Find(MatchIds[0]);
+}
+
+void UChessMatchSubsystem::GetMatchesForPlayer(const AController* Player, TArray<FChessMatch*>& OutMatches)
+{
+    TArray<int32, TInlineAllocator<8>> MatchIds;
+    if (Player) PlayerMatchIds.MultiFind(Player, MatchIds, true);
+    for (int32 MatchId : MatchIds)
+    {
+        if (FChessMatch* Match = Matches.Find(MatchId)) OutMatches.Add(Match);
+    }
+}
+
+AChessBoard* UChessMatchSubsystem::FindBoardForPlayer(const AController* Player)
+{
+    const FChessMatch* Match = FindMatchForPlayer(Player);
+    return Match ? Match->Board : nullptr;
+}
+
+AChessBoard* UChessMatchSubsystem::FindBoardToSpectate(int32 MatchId)
+{
+    if (const FChessMatch* Match = FindMatch(MatchId))
+    {
+        if (Match->Board) return Match->Board;
+    }
+
+    AChessBoard* AnyBoard = nullptr;
+    for (const TPair<int32, FChessMatch>& Match : Matches)
+    {
+        if (!Match.Value.Board) continue;
+        if (Match.Value.HasPlayers()) return Match.Value.Board;
+        if (!AnyBoard) AnyBoard = Match.Value.Board;
+    }
+    return AnyBoard;
+}
@@ -0,0 +1,87 @@
+// Copyright (©) 2024, Van Phan. All rights reserved.
+
+
+#include "Subsystems/ChessPieceRenderSubsystem.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+
+bool UChessPieceRenderSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+    return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+int32 UChessPieceRenderSubsystem::AddInstance(UStaticMesh* Mesh, UMaterialInterface* Material, const FTransform& Transform)
+{
+    if (!Mesh || GetWorld()->GetNetMode() == NM_DedicatedServer) return INDEX_NONE;
+
+    UHierarchicalInstancedStaticMeshComponent* Batch = FindOrAddBatch(Mesh, Material);
+    if (!Batch) return INDEX_NONE;
+
+    TArray<int32>& FreeSlots = FreeInstances.FindOrAdd(Mesh);
+    if (FreeSlots.Num() > 0)
+    {
+        const int32 Instance = FreeSlots.Pop();
+        Batch->UpdateInstanceTransform(Instance, Transform, true, true, true);
+        return Instance;
+    }
+    return Batch->AddInstance(Transform, true);
+}
+
+void UChessPieceRenderSubsystem::RemoveInstance(UStaticMesh* Mesh, int32 Instance)
+{
+    UHierarchicalInstancedStaticMeshComponent** Batch = Batches.Find(Mesh);
+    if (!Batch || !*Batch || !(*Batch)->IsValidInstance(Instance)) return;
+
+    UpdateInstance(Mesh, Instance, FTransform::Identity, false);
+    SetInstanceData(Mesh, Instance, false, false);
+    FreeInstances.FindOrAdd(Mesh).Add(Instance);
+}
+
+void UChessPieceRenderSubsystem::UpdateInstance(UStaticMesh* Mesh, int32 Instance, const FTransform& Transform, bool bVisible)
+{
+    UHierarchicalInstancedStaticMeshComponent** Batch = Batches.Find(Mesh);
+    if (!Batch || !*Batch || !(*Batch)->IsValidInstance(Instance)) return;
+
+    // Hidden instances keep their slot, scaled to nothing
+    FTransform InstanceTransform = Transform;
+    if (!bVisible) InstanceTransform.SetScale3D(FVector::ZeroVector);
+    (*Batch)->UpdateInstanceTransform(Instance, InstanceTransform, true, true, true);
+}
+
+void UChessPieceRenderSubsystem::SetInstanceData(UStaticMesh* Mesh, int32 Instance, bool bBlack, bool bHighlighted)
+{
+    UHierarchicalInstancedStaticMeshComponent** Batch = Batches.Find(Mesh);
+    if (!Batch || !*Batch || !(*Batch)->IsValidInstance(Instance)) return;
+
+    (*Batch)->SetCustomDataValue(Instance, TeamDataIndex, bBlack ? 1.0f : 0.0f, false);
+    (*Batch)->SetCustomDataValue(Instance, HighlightDataIndex, bHighlighted ? 1.0f : 0.0f, true);
+}
+
+UHierarchicalInstancedStaticMeshComponent* UChessPieceRenderSubsystem::FindOrAddBatch(UStaticMesh* Mesh, UMaterialInterface* Material)
+{
+    if (UHierarchicalInstancedStaticMeshComponent** Batch = Batches.Find(Mesh)) return *Batch;
+
+    if (!InstanceActor)
+    {
+        FActorSpawnParameters SpawnParams;
+        SpawnParams.ObjectFlags |= RF_Transient;
+        InstanceActor = GetWorld()->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, SpawnParams);
+        if (!InstanceActor) return nullptr;
+    }
+
+    // Pieces keep their own hidden meshes for collision, the batches only draw
+    UHierarchicalInstancedStaticMeshComponent* Batch = NewObject<UHierarchicalInstancedStaticMeshComponent>(InstanceActor);
+    Batch->SetMobility(EComponentMobility::Movable);
+    Batch->SetStaticMesh(Mesh);
+    if (Material) Batch->SetMaterial(0, Material);
+    Batch->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+    Batch->SetNumCustomDataFloats(NumCustomData);
+    if (!InstanceActor->GetRootComponent()) InstanceActor->SetRootComponent(Batch);
+    else Batch->SetupAttachment(InstanceActor->GetRootComponent());
+    Batch->RegisterComponent();
+    InstanceActor->AddInstanceComponent(Batch);
+
+    Batches.Add(Mesh, Batch);
+    return Batch;
+}
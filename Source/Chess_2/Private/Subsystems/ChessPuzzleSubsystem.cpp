@@ -0,0 +1,37 @@
+// Copyright (©) 2024, Van Phan. All rights reserved.
+
+
+#include "Subsystems/ChessPuzzleSubsystem.h"
+#include "Misc/Paths.h"
+
+void UChessPuzzleSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+    Super::Initialize(Collection);
+
+    Random.GenerateNewSeed();
+    const FString Filename = FChessPuzzleDatabase::GetDefaultFilename();
+    if (FPaths::FileExists(Filename) && Database.Open(Filename))
+    {
+        UE_LOG(LogTemp, Display, TEXT("Mapped %d puzzles from %s"), Database.Num(), *Filename);
+    }
+}
+
+void UChessPuzzleSubsystem::Deinitialize()
+{
+    Database.Close();
+    Super::Deinitialize();
+}
+
+bool UChessPuzzleSubsystem::PickPuzzle(int32 MinRating, int32 MaxRating, int32 Theme, FChessPuzzle& OutPuzzle)
+{
+    // The builder already checked every puzzle, this only guards against a database from an older rules version
+    for (int32 Attempt = 0; Attempt < MaxPickAttempts; Attempt++)
+    {
+        const int32 Index = Database.PickRandom(MinRating, MaxRating, Theme, Random);
+        if (Index == INDEX_NONE) return false;
+        if (Database.GetPuzzle(Index, OutPuzzle) && OutPuzzle.IsPlayable()) return true;
+
+        UE_LOG(LogTemp, Warning, TEXT("Puzzle %d can't be played, picking another"), Index);
+    }
+    return false;
+}
@@ -0,0 +1,55 @@
+// Copyright (©) 2024, Van Phan. All rights reserved.
+
+
+#include "Utility/ChessEndTurnBenchmark.h"
+#include "GameModes/ChessGameMode.h"
+#include "Actors/ChessBoard.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Misc/AutomationTest.h"
+#include "Tests/AutomationCommon.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    UWorld* FindGameWorld()
+    {
+        for (const FWorldContext& Context : GEngine->GetWorldContexts())
+        {
+            if ((Context.WorldType == EWorldType::Game || Context.WorldType == EWorldType::PIE) && Context.World()) return Context.World();
+        }
+        return nullptr;
+    }
+}
+
+// Waits for the map's boards to finish building, then runs the whole corpus in one go
+DEFINE_LATENT_AUTOMATION_COMMAND_TWO_PARAMETER(FChessRunEndTurnBenchmarkCommand, FAutomationTestBase*, Test, int32, Iterations);
+
+bool FChessRunEndTurnBenchmarkCommand::Update()
+{
+    UWorld* World = FindGameWorld();
+    AChessGameMode* GameMode = World ? World->GetAuthGameMode<AChessGameMode>() : nullptr;
+    AChessBoard* IdleBoard = FChessEndTurnBenchmark::FindIdleBoard(World);
+    if (!GameMode || !IdleBoard)
+    {
+        if (GetCurrentRunTime() < 10.0) return false;
+        Test->AddError(TEXT("EndTurn benchmark needs a chess game mode and a board without a match on it"));
+        return true;
+    }
+
+    Test->TestTrue(TEXT("Every position's EndTurn p99 is within budget"), FChessEndTurnBenchmark::Run(GameMode, IdleBoard, Iterations));
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FChessEndTurnBenchmarkTest, "Chess.Benchmarks.EndTurn", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FChessEndTurnBenchmarkTest::RunTest(const FString& Parameters)
+{
+    // 200 samples a position keeps p99 meaningful
+    AutomationOpenMap(TEXT("/Game/Levels/Game"));
+    ADD_LATENT_AUTOMATION_COMMAND(FChessRunEndTurnBenchmarkCommand(this, 200));
+    return true;
+}
+
+#endif
@@ -0,0 +1,58 @@
+// Copyright (©) 2024, Van Phan. All rights reserved.
+
+
+#include "Utility/ChessMoveGenerator.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FChessMoveGeneratorPerftTest, "Chess.MoveGenerator.Perft", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FChessMoveGeneratorPerftTest::RunTest(const FString& Parameters)
+{
+    // The standard perft suite, between them they cover castling through check, en passant, promotions and pins
+    struct FPerftCase
+    {
+        const TCHAR* Name;
+        const TCHAR* Fen;
+        int32 Depth;
+        uint64 Nodes;
+    };
+    const FPerftCase Cases[] =
+    {
+        { TEXT("Start position"), TEXT("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"), 4, 197281 },
+        { TEXT("Kiwipete"), TEXT("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1"), 3, 97862 },
+        { TEXT("Position 3"), TEXT("8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1"), 5, 674624 },
+        { TEXT("Position 4"), TEXT("r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1"), 4, 422333 },
+        { TEXT("Position 5"), TEXT("rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8"), 3, 62379 },
+    };
+
+    for (const FPerftCase& Case : Cases)
+    {
+        FChessPosition Position;
+        if (!TestTrue(FString::Printf(TEXT("%s parses"), Case.Name), Position.SetFromFen(Case.Fen))) continue;
+        TestEqual(FString::Printf(TEXT("%s perft %d"), Case.Name, Case.Depth), FChessMoveGenerator::Perft(Position, Case.Depth), Case.Nodes);
+    }
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FChessMoveGeneratorNotationTest, "Chess.MoveGenerator.Notation", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FChessMoveGeneratorNotationTest::RunTest(const FString& Parameters)
+{
+    // Every legal move has to survive a trip through SAN and UCI, the EPD runner and puzzles read both
+    FChessPosition Position;
+    TestTrue(TEXT("Kiwipete parses"), Position.SetFromFen(TEXT("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1")));
+
+    FChessMoveList Moves;
+    FChessMoveGenerator::GenerateLegalMoves(Position, Moves);
+    for (uint16 Move : Moves)
+    {
+        const FString San = FChessMoveGenerator::MoveToSan(Position, Move);
+        TestEqual(FString::Printf(TEXT("%s round trips through SAN"), *San), FChessMoveGenerator::ParseSan(Position, San), Move);
+        TestEqual(FString::Printf(TEXT("%s round trips through UCI"), *San), FChessMoveGenerator::ParseUci(Position, FChessMoveGenerator::MoveToUci(Move)), Move);
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,74 @@
+// Copyright (©) 2024, Van Phan. All rights reserved.
+
+
+#include "Utility/ChessClock.h"
+
+void FChessClock::Start(int32 BaseMs, int32 InIncrementMs, int32 InDelayMs, bool bInWhiteToMove, double Now)
+{
+    WhiteRemainingMs = FMath::Max(BaseMs, 0);
+    BlackRemainingMs = WhiteRemainingMs;
+    IncrementMs = (uint16)FMath::Clamp(InIncrementMs, 0, (int32)MAX_uint16);
+    DelayMs = (uint16)FMath::Clamp(InDelayMs, 0, (int32)MAX_uint16);
+    bWhiteToMove = bInWhiteToMove;
+    TurnStartTime = Now;
+    bRunning = IsEnabled();
+}
+
+void FChessClock::Stop(double Now)
+{
+    if (!bRunning) return;
+
+    int32& MoverRemainingMs = bWhiteToMove ? WhiteRemainingMs : BlackRemainingMs;
+    MoverRemainingMs = FMath::Max(MoverRemainingMs - GetChargedMs(Now, 0), 0);
+    TurnStartTime = Now;
+    bRunning = false;
+}
+
+void FChessClock::SetSideToMove(bool bInWhiteToMove, double Now)
+{
+    if (!bRunning || bWhiteToMove == bInWhiteToMove) return;
+
+    int32& MoverRemainingMs = bWhiteToMove ? WhiteRemainingMs : BlackRemainingMs;
+    MoverRemainingMs = FMath::Max(MoverRemainingMs - GetChargedMs(Now, 0), 0);
+    bWhiteToMove = bInWhiteToMove;
+    TurnStartTime = Now;
+}
+
+bool FChessClock::Press(double MoveTime, double Now, int32 LatencyCreditMs)
+{
+    if (!bRunning) return true;
+
+    int32& MoverRemainingMs = bWhiteToMove ? WhiteRemainingMs : BlackRemainingMs;
+    MoverRemainingMs -= GetChargedMs(MoveTime, LatencyCreditMs);
+    if (MoverRemainingMs <= 0)
+    {
+        MoverRemainingMs = 0;
+        TurnStartTime = Now;
+        bRunning = false;
+        return false;
+    }
+
+    MoverRemainingMs += IncrementMs;
+    bWhiteToMove = !bWhiteToMove;
+    TurnStartTime = Now;
+    return true;
+}
+
+int32 FChessClock::GetChargedMs(double Until, int32 LatencyCreditMs) const
+{
+    const int32 ElapsedMs = FMath::FloorToInt32((Until - TurnStartTime) * 1000.0) - FMath::Max(LatencyCreditMs, 0);
+    return FMath::Max(ElapsedMs - DelayMs, 0);
+}
+
+int32 FChessClock::GetRemainingMs(bool bWhite, double Now) const
+{
+    const int32 RemainingMs = bWhite ? WhiteRemainingMs : BlackRemainingMs;
+    if (!bRunning || bWhite != bWhiteToMove) return RemainingMs;
+    return FMath::Max(RemainingMs - GetChargedMs(Now, 0), 0);
+}
+
+double FChessClock::GetSecondsUntilFlag(double Now) const
+{
+    const int32 RemainingMs = bWhiteToMove ? WhiteRemainingMs : BlackRemainingMs;
+    return (RemainingMs + DelayMs) / 1000.0 - (Now - TurnStartTime);
+}
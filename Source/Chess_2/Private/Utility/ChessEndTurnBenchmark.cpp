@@ -0,0 +1,123 @@
+// Copyright (©) 2024, Van Phan. All rights reserved.
+
+
+#include "Utility/ChessEndTurnBenchmark.h"
+#include "Actors/ChessBoard.h"
+#include "GameModes/ChessGameMode.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/PlatformTime.h"
+#include "EngineUtils.h"
+
+namespace
+{
+    double GetPercentile(const TArray<double>& SortedSamples, double Percentile)
+    {
+        if (SortedSamples.IsEmpty()) return 0.0;
+        const int32 Index = FMath::Clamp(FMath::CeilToInt(SortedSamples.Num() * Percentile) - 1, 0, SortedSamples.Num() - 1);
+        return SortedSamples[Index];
+    }
+}
+
+FString FChessEndTurnBenchmark::GetDefaultCorpusFilename()
+{
+    return FPaths::ProjectConfigDir() / TEXT("Benchmarks") / TEXT("EndTurnCorpus.txt");
+}
+
+AChessBoard* FChessEndTurnBenchmark::FindIdleBoard(UWorld* World)
+{
+    if (!World) return nullptr;
+    for (TActorIterator<AChessBoard> It(World); It; ++It)
+    {
+        if (!It->GetWhitePlayer() && !It->GetBlackPlayer() && It->IsBoardReady()) return *It;
+    }
+    return nullptr;
+}
+
+bool FChessEndTurnBenchmark::LoadCorpus(const FString& Filename, TArray<FChessBenchmarkPosition>& OutPositions)
+{
+    TArray<FString> Lines;
+    if (!FFileHelper::LoadFileToStringArray(Lines, *Filename)) return false;
+
+    for (const FString& Line : Lines)
+    {
+        const FString Trimmed = Line.TrimStartAndEnd();
+        if (Trimmed.IsEmpty() || Trimmed.StartsWith(TEXT("#"))) continue;
+
+        TArray<FString> Fields;
+        Trimmed.ParseIntoArray(Fields, TEXT("|"));
+        if (Fields.Num() != 3)
+        {
+            UE_LOG(LogTemp, Warning, TEXT("Skipping benchmark line \"%s\", expected Name | FEN | budget"), *Trimmed);
+            continue;
+        }
+
+        FChessBenchmarkPosition& Position = OutPositions.AddDefaulted_GetRef();
+        Position.Name = Fields[0].TrimStartAndEnd();
+        Position.Fen = Fields[1].TrimStartAndEnd();
+        Position.BudgetMs = FCString::Atod(*Fields[2].TrimStartAndEnd());
+    }
+    return OutPositions.Num() > 0;
+}
+
+bool FChessEndTurnBenchmark::Run(AChessGameMode* GameMode, AChessBoard* ChessBoard, int32 Iterations)
+{
+    if (!GameMode || !ChessBoard) return false;
+
+    TArray<FChessBenchmarkPosition> Positions;
+    const FString CorpusFilename = GetDefaultCorpusFilename();
+    if (!LoadCorpus(CorpusFilename, Positions))
+    {
+        UE_LOG(LogTemp, Error, TEXT("No benchmark positions in %s"), *CorpusFilename);
+        return false;
+    }
+
+    const FString OriginalFen = ChessBoard->GetFen();
+    FString Csv = TEXT("Position,Iterations,P50Ms,P99Ms,BudgetMs,Passed\n");
+    bool bAllPassed = true;
+
+    TArray<double> Samples;
+    Samples.Reserve(Iterations);
+    for (const FChessBenchmarkPosition& Position : Positions)
+    {
+        Samples.Reset();
+        for (int32 Iteration = 0; Iteration < Iterations; Iteration++)
+        {
+            if (!ChessBoard->LoadFen(Position.Fen))
+            {
+                UE_LOG(LogTemp, Error, TEXT("Benchmark position %s can't be set up"), *Position.Name);
+                break;
+            }
+
+            // EndTurn hands the turn over, so start on the other side and the FEN's side to move is the one evaluated
+            ChessBoard->CurrentTeamTurn = ChessBoard->CurrentTeamTurn == EChessTeam::White ? EChessTeam::Black : EChessTeam::White;
+
+            const uint64 StartCycles = FPlatformTime::Cycles64();
+            GameMode->EndTurn(ChessBoard);
+            Samples.Add(FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles));
+        }
+        if (Samples.IsEmpty())
+        {
+            bAllPassed = false;
+            continue;
+        }
+
+        Samples.Sort();
+        const double P50 = GetPercentile(Samples, 0.5);
+        const double P99 = GetPercentile(Samples, 0.99);
+        const bool bPassed = Position.BudgetMs <= 0.0 || P99 <= Position.BudgetMs;
+        bAllPassed &= bPassed;
+
+        Csv += FString::Printf(TEXT("%s,%d,%.4f,%.4f,%.4f,%s\n"), *Position.Name, Samples.Num(), P50, P99, Position.BudgetMs, bPassed ? TEXT("true") : TEXT("false"));
+        UE_LOG(LogTemp, Display, TEXT("EndTurn %s: p50 %.3f ms, p99 %.3f ms, budget %.3f ms"), *Position.Name, P50, P99, Position.BudgetMs);
+        if (!bPassed) UE_LOG(LogTemp, Error, TEXT("EndTurn %s is over budget"), *Position.Name);
+    }
+
+    // Leave the board as the benchmark found it
+    ChessBoard->LoadFen(OriginalFen);
+    ChessBoard->CurrentEndGameState = EEndGameState::EndGameStateNone;
+
+    const FString CsvFilename = FPaths::ProjectSavedDir() / TEXT("Benchmarks") / FString::Printf(TEXT("EndTurn-%s.csv"), *FDateTime::Now().ToString());
+    if (FFileHelper::SaveStringToFile(Csv, *CsvFilename)) UE_LOG(LogTemp, Display, TEXT("EndTurn benchmark written to %s"), *CsvFilename);
+    return bAllPassed;
+}
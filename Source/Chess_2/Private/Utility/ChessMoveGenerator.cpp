@@ -0,0 +1,354 @@
+// Copyright (©) 2024, Van Phan. All rights reserved.
+
+
+#include "Utility/ChessMoveGenerator.h"
+
+namespace
+{
+    const int32 KnightOffsets[8][2] = { {1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2} };
+    const int32 KingOffsets[8][2] = { {1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1} };
+    const int32 BishopDirections[4][2] = { {1, 1}, {-1, 1}, {1, -1}, {-1, -1} };
+    const int32 RookDirections[4][2] = { {1, 0}, {-1, 0}, {0, 1}, {0, -1} };
+    const uint8 PromotionTypes[4] = { ChessPiece::Queen, ChessPiece::Rook, ChessPiece::Bishop, ChessPiece::Knight };
+
+    // Indexed by piece type, same letters as FEN
+    const TCHAR SanLetters[] = TEXT(" PNBRQK");
+
+    FORCEINLINE bool IsOnBoard(int32 File, int32 Rank) { return File >= 0 && File < 8 && Rank >= 0 && Rank < 8; }
+    FORCEINLINE bool IsPieceOf(uint8 Code, bool bWhite) { return Code != ChessPiece::None && ChessPiece::IsBlack(Code) != bWhite; }
+    FORCEINLINE bool IsPiece(uint8 Code, uint8 Type, bool bWhite) { return Code == ChessPiece::Make(Type, !bWhite); }
+
+    void AddPawnMove(FChessMoveList& Moves, int32 From, int32 To, bool bWhite)
+    {
+        if (FChessPosition::GetRank(To) == (bWhite ? 7 : 0))
+        {
+            for (uint8 Type : PromotionTypes) Moves.Add(ChessMove::Make(From, To, Type));
+        }
+        else
+        {
+            Moves.Add(ChessMove::Make(From, To));
+        }
+    }
+
+    FString GetSquareName(int32 Square)
+    {
+        FString Name;
+        Name.AppendChar(TEXT('a') + FChessPosition::GetFile(Square));
+        Name.AppendChar(TEXT('1') + FChessPosition::GetRank(Square));
+        return Name;
+    }
+
+    // SAN without check suffixes, annotations or the promotion '=', so different spellings compare equal
+    FString NormaliseSan(const FString& San)
+    {
+        FString Normalised;
+        for (const TCHAR Letter : San)
+        {
+            if (Letter == TEXT('+') || Letter == TEXT('#') || Letter == TEXT('!') || Letter == TEXT('?') || Letter == TEXT('=')) continue;
+            Normalised.AppendChar(Letter == TEXT('0') ? TEXT('O') : Letter);
+        }
+        return Normalised;
+    }
+}
+
+void FChessMoveGenerator::GenerateLegalMoves(const FChessPosition& Position, FChessMoveList& OutMoves)
+{
+    OutMoves.Reset();
+    GeneratePseudoLegalMoves(Position, OutMoves, false);
+    FilterLegal(Position, OutMoves);
+}
+
+void FChessMoveGenerator::GenerateLegalCaptures(const FChessPosition& Position, FChessMoveList& OutMoves)
+{
+    OutMoves.Reset();
+    GeneratePseudoLegalMoves(Position, OutMoves, true);
+    FilterLegal(Position, OutMoves);
+}
+
+bool FChessMoveGenerator::IsLegalMove(const FChessPosition& Position, uint16 Move)
+{
+    FChessMoveList Moves;
+    GenerateLegalMoves(Position, Moves);
+    return Moves.Contains(Move);
+}
+
+void FChessMoveGenerator::GeneratePseudoLegalMoves(const FChessPosition& Position, FChessMoveList& OutMoves, bool bCapturesOnly)
+{
+    const bool bWhite = Position.bWhiteToMove;
+
+    for (int32 From = 0; From < 64; From++)
+    {
+        const uint8 Code = Position.Squares[From];
+        if (!IsPieceOf(Code, bWhite)) continue;
+
+        const int32 File = FChessPosition::GetFile(From);
+        const int32 Rank = FChessPosition::GetRank(From);
+
+        switch (ChessPiece::GetType(Code))
+        {
+            case ChessPiece::Pawn:
+            {
+                if (Rank == (bWhite ? 7 : 0)) break; // Only in hand written FENs
+                const int32 Forward = bWhite ? 1 : -1;
+                const int32 OneStep = From + Forward * 8;
+                const bool bPromotes = FChessPosition::GetRank(OneStep) == (bWhite ? 7 : 0);
+                if (Position.Squares[OneStep] == ChessPiece::None && (!bCapturesOnly || bPromotes))
+                {
+                    AddPawnMove(OutMoves, From, OneStep, bWhite);
+
+                    const int32 TwoStep = OneStep + Forward * 8;
+                    if (!bCapturesOnly && Rank == (bWhite ? 1 : 6) && Position.Squares[TwoStep] == ChessPiece::None) OutMoves.Add(ChessMove::Make(From, TwoStep));
+                }
+
+                for (int32 Side = -1; Side <= 1; Side += 2)
+                {
+                    if (!IsOnBoard(File + Side, Rank + Forward)) continue;
+                    const int32 To = FChessPosition::MakeSquare(File + Side, Rank + Forward);
+                    if (IsPieceOf(Position.Squares[To], !bWhite) || To == Position.EnPassantSquare) AddPawnMove(OutMoves, From, To, bWhite);
+                }
+                break;
+            }
+            case ChessPiece::Knight:
+            case ChessPiece::King:
+            {
+                const int32 (*Offsets)[2] = ChessPiece::GetType(Code) == ChessPiece::Knight ? KnightOffsets : KingOffsets;
+                for (int32 Index = 0; Index < 8; Index++)
+                {
+                    if (!IsOnBoard(File + Offsets[Index][0], Rank + Offsets[Index][1])) continue;
+                    const int32 To = FChessPosition::MakeSquare(File + Offsets[Index][0], Rank + Offsets[Index][1]);
+                    const uint8 Target = Position.Squares[To];
+                    if (Target == ChessPiece::None ? !bCapturesOnly : IsPieceOf(Target, !bWhite)) OutMoves.Add(ChessMove::Make(From, To));
+                }
+                break;
+            }
+            default:
+            {
+                const uint8 Type = ChessPiece::GetType(Code);
+                for (int32 Direction = 0; Direction < 8; Direction++)
+                {
+                    // Bishops take the first four, rooks the last four and queens all eight
+                    const bool bDiagonal = Direction < 4;
+                    if ((bDiagonal && Type == ChessPiece::Rook) || (!bDiagonal && Type == ChessPiece::Bishop)) continue;
+                    const int32* Step = bDiagonal ? BishopDirections[Direction] : RookDirections[Direction - 4];
+
+                    for (int32 Distance = 1; IsOnBoard(File + Step[0] * Distance, Rank + Step[1] * Distance); Distance++)
+                    {
+                        const int32 To = FChessPosition::MakeSquare(File + Step[0] * Distance, Rank + Step[1] * Distance);
+                        const uint8 Target = Position.Squares[To];
+                        if (Target == ChessPiece::None)
+                        {
+                            if (!bCapturesOnly) OutMoves.Add(ChessMove::Make(From, To));
+                            continue;
+                        }
+                        if (IsPieceOf(Target, !bWhite)) OutMoves.Add(ChessMove::Make(From, To));
+                        break;
+                    }
+                }
+                break;
+            }
+        }
+    }
+
+    if (bCapturesOnly) return;
+
+    // Castling, the rook must still be there and the king can't pass through check
+    const int32 KingSquare = bWhite ? 4 : 60;
+    if (!IsPiece(Position.Squares[KingSquare], ChessPiece::King, bWhite)) return;
+
+    const uint8 KingsideRight = bWhite ? ChessCastling::WhiteKingside : ChessCastling::BlackKingside;
+    const uint8 QueensideRight = bWhite ? ChessCastling::WhiteQueenside : ChessCastling::BlackQueenside;
+    if (!(Position.CastlingRights & (KingsideRight | QueensideRight)) || IsSquareAttacked(Position, KingSquare, !bWhite)) return;
+
+    if ((Position.CastlingRights & KingsideRight) && IsPiece(Position.Squares[KingSquare + 3], ChessPiece::Rook, bWhite)
+        && Position.Squares[KingSquare + 1] == ChessPiece::None && Position.Squares[KingSquare + 2] == ChessPiece::None
+        && !IsSquareAttacked(Position, KingSquare + 1, !bWhite) && !IsSquareAttacked(Position, KingSquare + 2, !bWhite))
+    {
+        OutMoves.Add(ChessMove::Make(KingSquare, KingSquare + 2));
+    }
+
+    if ((Position.CastlingRights & QueensideRight) && IsPiece(Position.Squares[KingSquare - 4], ChessPiece::Rook, bWhite)
+        && Position.Squares[KingSquare - 1] == ChessPiece::None && Position.Squares[KingSquare - 2] == ChessPiece::None && Position.Squares[KingSquare - 3] == ChessPiece::None
+        && !IsSquareAttacked(Position, KingSquare - 1, !bWhite) && !IsSquareAttacked(Position, KingSquare - 2, !bWhite))
+    {
+        OutMoves.Add(ChessMove::Make(KingSquare, KingSquare - 2));
+    }
+}
+
+void FChessMoveGenerator::FilterLegal(const FChessPosition& Position, FChessMoveList& Moves)
+{
+    const bool bWhite = Position.bWhiteToMove;
+    for (int32 Index = Moves.Num() - 1; Index >= 0; Index--)
+    {
+        FChessPosition After = Position;
+        const int32 KingSquare = After.ApplyMove(Moves[Index]) ? FindKing(After, bWhite) : INDEX_NONE;
+        if (KingSquare == INDEX_NONE || IsSquareAttacked(After, KingSquare, !bWhite)) Moves.RemoveAtSwap(Index);
+    }
+}
+
+bool FChessMoveGenerator::IsSquareAttacked(const FChessPosition& Position, int32 Square, bool bByWhite)
+{
+    const int32 File = FChessPosition::GetFile(Square);
+    const int32 Rank = FChessPosition::GetRank(Square);
+
+    // Pawns attack towards the other side, so look one rank back from their point of view
+    const int32 PawnRank = Rank + (bByWhite ? -1 : 1);
+    for (int32 Side = -1; Side <= 1; Side += 2)
+    {
+        if (IsOnBoard(File + Side, PawnRank) && IsPiece(Position.Squares[FChessPosition::MakeSquare(File + Side, PawnRank)], ChessPiece::Pawn, bByWhite)) return true;
+    }
+
+    for (int32 Index = 0; Index < 8; Index++)
+    {
+        if (IsOnBoard(File + KnightOffsets[Index][0], Rank + KnightOffsets[Index][1])
+            && IsPiece(Position.Squares[FChessPosition::MakeSquare(File + KnightOffsets[Index][0], Rank + KnightOffsets[Index][1])], ChessPiece::Knight, bByWhite)) return true;
+        if (IsOnBoard(File + KingOffsets[Index][0], Rank + KingOffsets[Index][1])
+            && IsPiece(Position.Squares[FChessPosition::MakeSquare(File + KingOffsets[Index][0], Rank + KingOffsets[Index][1])], ChessPiece::King, bByWhite)) return true;
+    }
+
+    for (int32 Direction = 0; Direction < 8; Direction++)
+    {
+        const bool bDiagonal = Direction < 4;
+        const int32* Step = bDiagonal ? BishopDirections[Direction] : RookDirections[Direction - 4];
+        for (int32 Distance = 1; IsOnBoard(File + Step[0] * Distance, Rank + Step[1] * Distance); Distance++)
+        {
+            const uint8 Code = Position.Squares[FChessPosition::MakeSquare(File + Step[0] * Distance, Rank + Step[1] * Distance)];
+            if (Code == ChessPiece::None) continue;
+            if (IsPiece(Code, ChessPiece::Queen, bByWhite) || IsPiece(Code, bDiagonal ? ChessPiece::Bishop : ChessPiece::Rook, bByWhite)) return true;
+            break;
+        }
+    }
+    return false;
+}
+
+bool FChessMoveGenerator::IsInCheck(const FChessPosition& Position)
+{
+    const int32 KingSquare = FindKing(Position, Position.bWhiteToMove);
+    return KingSquare != INDEX_NONE && IsSquareAttacked(Position, KingSquare, !Position.bWhiteToMove);
+}
+
+int32 FChessMoveGenerator::FindKing(const FChessPosition& Position, bool bWhite)
+{
+    const uint8 King = ChessPiece::Make(ChessPiece::King, !bWhite);
+    for (int32 Square = 0; Square < 64; Square++)
+    {
+        if (Position.Squares[Square] == King) return Square;
+    }
+    return INDEX_NONE;
+}
+
+bool FChessMoveGenerator::IsCapture(const FChessPosition& Position, uint16 Move)
+{
+    const int32 To = ChessMove::GetTo(Move);
+    if (Position.Squares[To] != ChessPiece::None) return true;
+    return To == Position.EnPassantSquare && ChessPiece::GetType(Position.Squares[ChessMove::GetFrom(Move)]) == ChessPiece::Pawn;
+}
+
+uint64 FChessMoveGenerator::Perft(const FChessPosition& Position, int32 Depth)
+{
+    if (Depth <= 0) return 1;
+
+    FChessMoveList Moves;
+    GenerateLegalMoves(Position, Moves);
+    if (Depth == 1) return Moves.Num(); // Counting the last ply is enough, nothing needs playing
+
+    uint64 Nodes = 0;
+    for (uint16 Move : Moves)
+    {
+        FChessPosition Child = Position;
+        Child.ApplyMove(Move);
+        Nodes += Perft(Child, Depth - 1);
+    }
+    return Nodes;
+}
+
+FString FChessMoveGenerator::MoveToSan(const FChessPosition& Position, uint16 Move)
+{
+    const int32 From = ChessMove::GetFrom(Move);
+    const int32 To = ChessMove::GetTo(Move);
+    const uint8 Type = ChessPiece::GetType(Position.Squares[From]);
+
+    FString San;
+    if (Type == ChessPiece::King && FMath::Abs(FChessPosition::GetFile(To) - FChessPosition::GetFile(From)) == 2)
+    {
+        San = FChessPosition::GetFile(To) > FChessPosition::GetFile(From) ? TEXT("O-O") : TEXT("O-O-O");
+    }
+    else
+    {
+        const bool bCapture = IsCapture(Position, Move);
+        if (Type == ChessPiece::Pawn)
+        {
+            if (bCapture) San.AppendChar(TEXT('a') + FChessPosition::GetFile(From));
+        }
+        else
+        {
+            San.AppendChar(SanLetters[Type]);
+
+            // Only as much of the from square as it takes to tell apart pieces of the same type reaching the same square
+            FChessMoveList Moves;
+            GenerateLegalMoves(Position, Moves);
+            bool bAmbiguous = false;
+            bool bSameFile = false;
+            bool bSameRank = false;
+            for (uint16 Other : Moves)
+            {
+                const int32 OtherFrom = ChessMove::GetFrom(Other);
+                if (OtherFrom == From || ChessMove::GetTo(Other) != To || ChessPiece::GetType(Position.Squares[OtherFrom]) != Type) continue;
+                bAmbiguous = true;
+                bSameFile |= FChessPosition::GetFile(OtherFrom) == FChessPosition::GetFile(From);
+                bSameRank |= FChessPosition::GetRank(OtherFrom) == FChessPosition::GetRank(From);
+            }
+            if (bAmbiguous && (!bSameFile || bSameRank)) San.AppendChar(TEXT('a') + FChessPosition::GetFile(From));
+            if (bAmbiguous && bSameFile) San.AppendChar(TEXT('1') + FChessPosition::GetRank(From));
+        }
+
+        if (bCapture) San.AppendChar(TEXT('x'));
+        San += GetSquareName(To);
+
+        if (ChessMove::GetPromotion(Move) != ChessPiece::None)
+        {
+            San.AppendChar(TEXT('='));
+            San.AppendChar(SanLetters[ChessMove::GetPromotion(Move)]);
+        }
+    }
+
+    FChessPosition After = Position;
+    if (After.ApplyMove(Move) && IsInCheck(After))
+    {
+        FChessMoveList Replies;
+        GenerateLegalMoves(After, Replies);
+        San.AppendChar(Replies.IsEmpty() ? TEXT('#') : TEXT('+'));
+    }
+    return San;
+}
+
+uint16 FChessMoveGenerator::ParseSan(const FChessPosition& Position, const FString& San)
+{
+    const FString Wanted = NormaliseSan(San);
+    if (Wanted.IsEmpty()) return ChessMove::None;
+
+    FChessMoveList Moves;
+    GenerateLegalMoves(Position, Moves);
+    for (uint16 Move : Moves)
+    {
+        if (NormaliseSan(MoveToSan(Position, Move)) == Wanted) return Move;
+    }
+    return ChessMove::None;
+}
+
+FString FChessMoveGenerator::MoveToUci(uint16 Move)
+{
+    FString Uci = GetSquareName(ChessMove::GetFrom(Move)) + GetSquareName(ChessMove::GetTo(Move));
+    if (ChessMove::GetPromotion(Move) != ChessPiece::None) Uci.AppendChar(FChar::ToLower(SanLetters[ChessMove::GetPromotion(Move)]));
+    return Uci;
+}
+
+uint16 FChessMoveGenerator::ParseUci(const FChessPosition& Position, const FString& Uci)
+{
+    FChessMoveList Moves;
+    GenerateLegalMoves(Position, Moves);
+    for (uint16 Move : Moves)
+    {
+        if (MoveToUci(Move).Equals(Uci, ESearchCase::IgnoreCase)) return Move;
+    }
+    return ChessMove::None;
+}
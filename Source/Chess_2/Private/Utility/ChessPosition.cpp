@@ -0,0 +1,257 @@
+// Copyright (©) 2024, Van Phan. All rights reserved.
+
+
+#include "Utility/ChessPosition.h"
+
+namespace
+{
+    uint64 SplitMix64(uint64& State)
+    {
+        uint64 Value = (State += 0x9E3779B97F4A7C15ull);
+        Value = (Value ^ (Value >> 30)) * 0xBF58476D1CE4E5B9ull;
+        Value = (Value ^ (Value >> 27)) * 0x94D049BB133111EBull;
+        return Value ^ (Value >> 31);
+    }
+
+    struct FChessZobristKeys
+    {
+        uint64 Pieces[16][64];
+        uint64 BlackToMove;
+        uint64 Castling[16];
+        uint64 EnPassantFile[8];
+
+        FChessZobristKeys()
+        {
+            // Never change the seed, hashes are compared between peers and stored alongside games
+            uint64 State = 0x43484553535A4F42ull;
+            for (int32 Code = 0; Code < 16; Code++)
+            {
+                for (int32 Square = 0; Square < 64; Square++) Pieces[Code][Square] = SplitMix64(State);
+            }
+            BlackToMove = SplitMix64(State);
+            for (int32 Rights = 0; Rights < 16; Rights++) Castling[Rights] = SplitMix64(State);
+            for (int32 File = 0; File < 8; File++) EnPassantFile[File] = SplitMix64(State);
+        }
+    };
+
+    const FChessZobristKeys& GetZobristKeys()
+    {
+        static const FChessZobristKeys Keys;
+        return Keys;
+    }
+
+    // Indexed by piece type, white pieces are the upper case letters
+    const TCHAR PieceLetters[] = TEXT(".pnbrqk");
+
+    uint8 GetPieceTypeFromLetter(TCHAR Letter)
+    {
+        const TCHAR* Found = FCString::Strchr(PieceLetters + 1, FChar::ToLower(Letter));
+        return Found ? (uint8)(Found - PieceLetters) : ChessPiece::None;
+    }
+
+    // Castling rights lost when a piece moves from or to this square
+    uint8 GetCastlingMask(int32 Square)
+    {
+        switch (Square)
+        {
+            case 0:  return ChessCastling::WhiteQueenside;
+            case 4:  return ChessCastling::WhiteKingside | ChessCastling::WhiteQueenside;
+            case 7:  return ChessCastling::WhiteKingside;
+            case 56: return ChessCastling::BlackQueenside;
+            case 60: return ChessCastling::BlackKingside | ChessCastling::BlackQueenside;
+            case 63: return ChessCastling::BlackKingside;
+            default: return 0;
+        }
+    }
+}
+
+void FChessPosition::Clear()
+{
+    FMemory::Memzero(Squares, sizeof(Squares));
+    bWhiteToMove = true;
+    CastlingRights = 0;
+    EnPassantSquare = INDEX_NONE;
+    HalfmoveClock = 0;
+    FullmoveNumber = 1;
+}
+
+int32 FChessPosition::CountPieces() const
+{
+    int32 Count = 0;
+    for (uint8 Code : Squares)
+    {
+        if (Code != ChessPiece::None) Count++;
+    }
+    return Count;
+}
+
+bool FChessPosition::ApplyMove(uint16 Move)
+{
+    const int32 From = ChessMove::GetFrom(Move);
+    const int32 To = ChessMove::GetTo(Move);
+    const uint8 MovingPiece = Squares[From];
+    if (MovingPiece == ChessPiece::None || ChessPiece::IsBlack(MovingPiece) == bWhiteToMove || From == To) return false;
+
+    const uint8 MovingType = ChessPiece::GetType(MovingPiece);
+    bool bCapture = Squares[To] != ChessPiece::None;
+
+    // En passant takes the pawn beside the mover, not the one on the target square
+    if (MovingType == ChessPiece::Pawn && To == EnPassantSquare && !bCapture)
+    {
+        Squares[To + (bWhiteToMove ? -8 : 8)] = ChessPiece::None;
+        bCapture = true;
+    }
+
+    // Castling is the king moving two files, the rook jumps over it
+    if (MovingType == ChessPiece::King && FMath::Abs(GetFile(To) - GetFile(From)) == 2)
+    {
+        const bool bKingside = GetFile(To) > GetFile(From);
+        const int32 RookFrom = MakeSquare(bKingside ? 7 : 0, GetRank(From));
+        const int32 RookTo = MakeSquare(bKingside ? 5 : 3, GetRank(From));
+        Squares[RookTo] = Squares[RookFrom];
+        Squares[RookFrom] = ChessPiece::None;
+    }
+
+    const uint8 Promotion = ChessMove::GetPromotion(Move);
+    Squares[To] = (MovingType == ChessPiece::Pawn && Promotion != ChessPiece::None) ? ChessPiece::Make(Promotion, !bWhiteToMove) : MovingPiece;
+    Squares[From] = ChessPiece::None;
+
+    CastlingRights &= ~(GetCastlingMask(From) | GetCastlingMask(To));
+    EnPassantSquare = (MovingType == ChessPiece::Pawn && FMath::Abs(To - From) == 16) ? (From + To) / 2 : INDEX_NONE;
+    HalfmoveClock = (MovingType == ChessPiece::Pawn || bCapture) ? 0 : FMath::Min(HalfmoveClock + 1, 255);
+    if (!bWhiteToMove) FullmoveNumber++;
+    bWhiteToMove = !bWhiteToMove;
+    return true;
+}
+
+uint64 FChessPosition::ComputeHash() const
+{
+    const FChessZobristKeys& Keys = GetZobristKeys();
+
+    uint64 Hash = 0;
+    for (int32 Square = 0; Square < 64; Square++)
+    {
+        if (Squares[Square] != ChessPiece::None) Hash ^= Keys.Pieces[Squares[Square] & 15][Square];
+    }
+    if (!bWhiteToMove) Hash ^= Keys.BlackToMove;
+    Hash ^= Keys.Castling[CastlingRights & 15];
+    if (EnPassantSquare != INDEX_NONE) Hash ^= Keys.EnPassantFile[GetFile(EnPassantSquare)];
+    return Hash;
+}
+
+bool FChessPosition::SetFromFen(const FString& Fen)
+{
+    TArray<FString> Fields;
+    Fen.ParseIntoArrayWS(Fields);
+    if (Fields.Num() < 2) return false;
+
+    FChessPosition NewPosition;
+
+    // Ranks run from the eighth down, files from a to h
+    int32 Rank = 7;
+    int32 File = 0;
+    for (const TCHAR Letter : Fields[0])
+    {
+        if (Letter == TEXT('/'))
+        {
+            if (File != 8 || Rank == 0) return false;
+            Rank--;
+            File = 0;
+        }
+        else if (Letter >= TEXT('1') && Letter <= TEXT('8'))
+        {
+            File += Letter - TEXT('0');
+            if (File > 8) return false;
+        }
+        else
+        {
+            const uint8 Type = GetPieceTypeFromLetter(Letter);
+            if (Type == ChessPiece::None || File > 7) return false;
+            NewPosition.Squares[MakeSquare(File, Rank)] = ChessPiece::Make(Type, FChar::IsLower(Letter));
+            File++;
+        }
+    }
+    if (Rank != 0 || File != 8) return false;
+
+    if (Fields[1] == TEXT("w")) NewPosition.bWhiteToMove = true;
+    else if (Fields[1] == TEXT("b")) NewPosition.bWhiteToMove = false;
+    else return false;
+
+    if (Fields.IsValidIndex(2) && Fields[2] != TEXT("-"))
+    {
+        for (const TCHAR Letter : Fields[2])
+        {
+            switch (Letter)
+            {
+                case TEXT('K'): NewPosition.CastlingRights |= ChessCastling::WhiteKingside; break;
+                case TEXT('Q'): NewPosition.CastlingRights |= ChessCastling::WhiteQueenside; break;
+                case TEXT('k'): NewPosition.CastlingRights |= ChessCastling::BlackKingside; break;
+                case TEXT('q'): NewPosition.CastlingRights |= ChessCastling::BlackQueenside; break;
+                default: return false;
+            }
+        }
+    }
+
+    if (Fields.IsValidIndex(3) && Fields[3] != TEXT("-"))
+    {
+        const FString& Target = Fields[3];
+        const TCHAR ExpectedRank = NewPosition.bWhiteToMove ? TEXT('6') : TEXT('3');
+        if (Target.Len() != 2 || Target[0] < TEXT('a') || Target[0] > TEXT('h') || Target[1] != ExpectedRank) return false;
+        NewPosition.EnPassantSquare = MakeSquare(Target[0] - TEXT('a'), Target[1] - TEXT('1'));
+    }
+
+    if (Fields.IsValidIndex(4)) NewPosition.HalfmoveClock = FMath::Clamp(FCString::Atoi(*Fields[4]), 0, 255);
+    if (Fields.IsValidIndex(5)) NewPosition.FullmoveNumber = FMath::Clamp(FCString::Atoi(*Fields[5]), 1, (int32)MAX_uint16);
+
+    *this = NewPosition;
+    return true;
+}
+
+FString FChessPosition::ToFen() const
+{
+    FString Fen;
+    for (int32 Rank = 7; Rank >= 0; Rank--)
+    {
+        int32 EmptySquares = 0;
+        for (int32 File = 0; File < 8; File++)
+        {
+            const uint8 Code = Squares[MakeSquare(File, Rank)];
+            const uint8 Type = ChessPiece::GetType(Code);
+            if (Type == ChessPiece::None || Type > ChessPiece::King)
+            {
+                EmptySquares++;
+                continue;
+            }
+
+            if (EmptySquares > 0) Fen.AppendInt(EmptySquares);
+            EmptySquares = 0;
+            Fen.AppendChar(ChessPiece::IsBlack(Code) ? PieceLetters[Type] : FChar::ToUpper(PieceLetters[Type]));
+        }
+        if (EmptySquares > 0) Fen.AppendInt(EmptySquares);
+        if (Rank > 0) Fen.AppendChar(TEXT('/'));
+    }
+
+    Fen += bWhiteToMove ? TEXT(" w ") : TEXT(" b ");
+
+    if (CastlingRights & ChessCastling::WhiteKingside) Fen.AppendChar(TEXT('K'));
+    if (CastlingRights & ChessCastling::WhiteQueenside) Fen.AppendChar(TEXT('Q'));
+    if (CastlingRights & ChessCastling::BlackKingside) Fen.AppendChar(TEXT('k'));
+    if (CastlingRights & ChessCastling::BlackQueenside) Fen.AppendChar(TEXT('q'));
+    if (CastlingRights == 0) Fen.AppendChar(TEXT('-'));
+
+    if (EnPassantSquare == INDEX_NONE) Fen += TEXT(" -");
+    else Fen += FString::Printf(TEXT(" %c%c"), TEXT('a') + GetFile(EnPassantSquare), TEXT('1') + GetRank(EnPassantSquare));
+
+    Fen += FString::Printf(TEXT(" %d %d"), HalfmoveClock, FullmoveNumber);
+    return Fen;
+}
+
+bool FChessPosition::operator==(const FChessPosition& Other) const
+{
+    return FMemory::Memcmp(Squares, Other.Squares, sizeof(Squares)) == 0
+        && bWhiteToMove == Other.bWhiteToMove
+        && CastlingRights == Other.CastlingRights
+        && EnPassantSquare == Other.EnPassantSquare
+        && HalfmoveClock == Other.HalfmoveClock
+        && FullmoveNumber == Other.FullmoveNumber;
+}
@@ -0,0 +1,259 @@
+// Copyright (©) 2024, Van Phan. All rights reserved.
+
+
+#include "Utility/ChessPuzzleDatabase.h"
+#include "Utility/ChessMoveGenerator.h"
+#include "HAL/PlatformFileManager.h"
+#include "Async/MappedFileHandle.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+static_assert(PLATFORM_LITTLE_ENDIAN, "Puzzle records are read in place as little endian");
+
+namespace
+{
+    const TCHAR* ThemeNames[ChessPuzzleFormat::NumThemes] =
+    {
+        TEXT("mateIn1"), TEXT("mateIn2"), TEXT("mateIn3"), TEXT("mate"),
+        TEXT("fork"), TEXT("pin"), TEXT("skewer"), TEXT("discoveredAttack"),
+        TEXT("doubleCheck"), TEXT("sacrifice"), TEXT("deflection"), TEXT("attraction"),
+        TEXT("clearance"), TEXT("interference"), TEXT("xRayAttack"), TEXT("zugzwang"),
+        TEXT("hangingPiece"), TEXT("trappedPiece"), TEXT("backRankMate"), TEXT("smotheredMate"),
+        TEXT("promotion"), TEXT("underPromotion"), TEXT("enPassant"), TEXT("castling"),
+        TEXT("quietMove"), TEXT("defensiveMove"), TEXT("opening"), TEXT("middlegame"),
+        TEXT("endgame"), TEXT("short"), TEXT("long"), TEXT("crushing"),
+    };
+
+    template<typename T>
+    void WriteValue(TArray<uint8>& Bytes, T Value)
+    {
+        Bytes.Append(reinterpret_cast<const uint8*>(&Value), sizeof(T));
+    }
+
+    template<typename T>
+    T ReadValue(const uint8* Cursor)
+    {
+        T Value;
+        FMemory::Memcpy(&Value, Cursor, sizeof(T));
+        return Value;
+    }
+}
+
+const TCHAR* ChessPuzzleTheme::GetName(int32 Theme)
+{
+    return (Theme >= 0 && Theme < ChessPuzzleFormat::NumThemes) ? ThemeNames[Theme] : TEXT("");
+}
+
+int32 ChessPuzzleTheme::FindTheme(const FString& Name)
+{
+    for (int32 Theme = 0; Theme < ChessPuzzleFormat::NumThemes; Theme++)
+    {
+        if (Name.Equals(ThemeNames[Theme], ESearchCase::IgnoreCase)) return Theme;
+    }
+    return INDEX_NONE;
+}
+
+bool FChessPuzzle::IsPlayable() const
+{
+    FChessPosition Position;
+    if (Solution.IsEmpty() || !Position.SetFromFen(Fen)) return false;
+
+    for (uint16 Move : Solution)
+    {
+        if (!FChessMoveGenerator::IsLegalMove(Position, Move)) return false;
+        Position.ApplyMove(Move);
+    }
+    return true;
+}
+
+FChessPuzzleDatabase::~FChessPuzzleDatabase()
+{
+    Close();
+}
+
+FString FChessPuzzleDatabase::GetDefaultFilename()
+{
+    return FPaths::ProjectContentDir() / TEXT("Puzzles") / TEXT("Puzzles.chesspuzzles");
+}
+
+bool FChessPuzzleDatabase::Open(const FString& Filename)
+{
+    Close();
+
+    MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Filename));
+    if (MappedFile.IsValid() && MappedFile->GetFileSize() > 0)
+    {
+        MappedRegion.Reset(MappedFile->MapRegion(0, MappedFile->GetFileSize()));
+    }
+
+    // Loading the whole set instead would defeat the format, so a file that can't be mapped isn't opened
+    if (!MappedRegion.IsValid())
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Couldn't map puzzle database %s, it has to be a loose file and not in a pak"), *Filename);
+        Close();
+        return false;
+    }
+    Data = MappedRegion->GetMappedPtr();
+    DataSize = MappedRegion->GetMappedSize();
+
+    bool bValid = Data && DataSize >= ChessPuzzleFormat::HeaderSize
+        && ReadValue<uint32>(Data) == ChessPuzzleFormat::Magic && ReadValue<uint16>(Data + 4) == ChessPuzzleFormat::Version;
+
+    // Every section has to fit, after this nothing is bounds checked again
+    if (bValid)
+    {
+        NumPuzzles = (int32)ReadValue<uint32>(Data + 8);
+        const int64 FenBytes = ReadValue<uint32>(Data + 12);
+
+        int64 Offset = ChessPuzzleFormat::HeaderSize + (int64)NumPuzzles * ChessPuzzleFormat::RecordSize;
+        for (int32 Theme = 0; Theme < ChessPuzzleFormat::NumThemes; Theme++)
+        {
+            ThemeCounts[Theme] = (int32)ReadValue<uint32>(Data + 16 + Theme * 4);
+            ThemeListOffsets[Theme] = Offset;
+            Offset += (int64)ThemeCounts[Theme] * sizeof(uint32);
+            bValid &= ThemeCounts[Theme] >= 0 && ThemeCounts[Theme] <= NumPuzzles;
+        }
+        FenOffset = Offset;
+        bValid &= NumPuzzles >= 0 && FenOffset + FenBytes <= DataSize;
+    }
+
+    // Theme lists are read straight into record offsets, so each entry has to name a puzzle that exists
+    for (int32 Theme = 0; bValid && Theme < ChessPuzzleFormat::NumThemes; Theme++)
+    {
+        for (int32 Entry = 0; bValid && Entry < ThemeCounts[Theme]; Entry++)
+        {
+            bValid = ReadValue<uint32>(Data + ThemeListOffsets[Theme] + Entry * sizeof(uint32)) < (uint32)NumPuzzles;
+        }
+    }
+
+    if (!bValid)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("%s isn't a puzzle database this build can read"), *Filename);
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void FChessPuzzleDatabase::Close()
+{
+    MappedRegion.Reset();
+    MappedFile.Reset();
+    Data = nullptr;
+    DataSize = 0;
+    NumPuzzles = 0;
+}
+
+int32 FChessPuzzleDatabase::GetRecordIndex(int32 Theme, int32 Entry) const
+{
+    return Theme == INDEX_NONE ? Entry : (int32)ReadValue<uint32>(Data + ThemeListOffsets[Theme] + Entry * sizeof(uint32));
+}
+
+uint16 FChessPuzzleDatabase::GetRating(int32 Theme, int32 Entry) const
+{
+    const int32 Record = GetRecordIndex(Theme, Entry);
+    return ReadValue<uint16>(Data + ChessPuzzleFormat::HeaderSize + Record * ChessPuzzleFormat::RecordSize + 4);
+}
+
+int32 FChessPuzzleDatabase::LowerBound(int32 Theme, int32 Rating) const
+{
+    int32 First = 0;
+    int32 Count = Theme == INDEX_NONE ? NumPuzzles : ThemeCounts[Theme];
+    while (Count > 0)
+    {
+        const int32 Step = Count / 2;
+        if (GetRating(Theme, First + Step) < Rating)
+        {
+            First += Step + 1;
+            Count -= Step + 1;
+        }
+        else
+        {
+            Count = Step;
+        }
+    }
+    return First;
+}
+
+int32 FChessPuzzleDatabase::PickRandom(int32 MinRating, int32 MaxRating, int32 Theme, FRandomStream& Random) const
+{
+    if (!Data || Theme < INDEX_NONE || Theme >= ChessPuzzleFormat::NumThemes) return INDEX_NONE;
+
+    const int32 First = LowerBound(Theme, MinRating);
+    const int32 End = LowerBound(Theme, MaxRating + 1);
+    if (First >= End) return INDEX_NONE;
+    return GetRecordIndex(Theme, Random.RandRange(First, End - 1));
+}
+
+bool FChessPuzzleDatabase::GetPuzzle(int32 Index, FChessPuzzle& OutPuzzle) const
+{
+    if (!Data || Index < 0 || Index >= NumPuzzles) return false;
+
+    const uint8* Record = Data + ChessPuzzleFormat::HeaderSize + Index * ChessPuzzleFormat::RecordSize;
+    const int64 FenStart = FenOffset + ReadValue<uint32>(Record);
+    const int32 FenLength = Record[6];
+    const int32 NumMoves = FMath::Min<int32>(Record[7], ChessPuzzleFormat::MaxSolutionMoves);
+    if (FenStart + FenLength > DataSize) return false;
+
+    OutPuzzle.Fen = FString(FenLength, reinterpret_cast<const ANSICHAR*>(Data + FenStart));
+    OutPuzzle.Rating = ReadValue<uint16>(Record + 4);
+    OutPuzzle.Themes = ReadValue<uint32>(Record + 8);
+    OutPuzzle.Solution.SetNum(NumMoves);
+    for (int32 Move = 0; Move < NumMoves; Move++)
+    {
+        OutPuzzle.Solution[Move] = ReadValue<uint16>(Record + 12 + Move * sizeof(uint16));
+    }
+    return true;
+}
+
+bool FChessPuzzleDatabase::Write(const FString& Filename, TArray<FChessPuzzle> Puzzles)
+{
+    Puzzles.RemoveAll([](const FChessPuzzle& Puzzle)
+    {
+        return Puzzle.Fen.Len() > MAX_uint8 || Puzzle.Solution.Num() > ChessPuzzleFormat::MaxSolutionMoves || !Puzzle.Fen.IsPureAnsi();
+    });
+    Puzzles.StableSort([](const FChessPuzzle& A, const FChessPuzzle& B) { return A.Rating < B.Rating; });
+
+    TArray<uint8> Fens;
+    TArray<uint32> ThemeLists[ChessPuzzleFormat::NumThemes];
+    TArray<uint8> Records;
+    Records.Reserve(Puzzles.Num() * ChessPuzzleFormat::RecordSize);
+    for (int32 Index = 0; Index < Puzzles.Num(); Index++)
+    {
+        const FChessPuzzle& Puzzle = Puzzles[Index];
+        WriteValue<uint32>(Records, Fens.Num());
+        WriteValue<uint16>(Records, Puzzle.Rating);
+        WriteValue<uint8>(Records, (uint8)Puzzle.Fen.Len());
+        WriteValue<uint8>(Records, (uint8)Puzzle.Solution.Num());
+        WriteValue<uint32>(Records, Puzzle.Themes);
+        for (int32 Move = 0; Move < ChessPuzzleFormat::MaxSolutionMoves; Move++)
+        {
+            WriteValue<uint16>(Records, Puzzle.Solution.IsValidIndex(Move) ? Puzzle.Solution[Move] : ChessMove::None);
+        }
+
+        Fens.Append(reinterpret_cast<const uint8*>(TCHAR_TO_ANSI(*Puzzle.Fen)), Puzzle.Fen.Len());
+        for (int32 Theme = 0; Theme < ChessPuzzleFormat::NumThemes; Theme++)
+        {
+            if (Puzzle.Themes & (1u << Theme)) ThemeLists[Theme].Add(Index);
+        }
+    }
+
+    TArray<uint8> Bytes;
+    WriteValue<uint32>(Bytes, ChessPuzzleFormat::Magic);
+    WriteValue<uint16>(Bytes, ChessPuzzleFormat::Version);
+    WriteValue<uint16>(Bytes, 0);
+    WriteValue<uint32>(Bytes, Puzzles.Num());
+    WriteValue<uint32>(Bytes, Fens.Num());
+    for (const TArray<uint32>& ThemeList : ThemeLists) WriteValue<uint32>(Bytes, ThemeList.Num());
+    Bytes.Append(Records);
+    for (const TArray<uint32>& ThemeList : ThemeLists) Bytes.Append(reinterpret_cast<const uint8*>(ThemeList.GetData()), ThemeList.Num() * sizeof(uint32));
+    Bytes.Append(Fens);
+
+    if (!FFileHelper::SaveArrayToFile(Bytes, *Filename))
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Couldn't write puzzle database %s"), *Filename);
+        return false;
+    }
+    UE_LOG(LogTemp, Display, TEXT("Wrote %d puzzles to %s"), Puzzles.Num(), *Filename);
+    return true;
+}
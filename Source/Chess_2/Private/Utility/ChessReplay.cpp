@@ -0,0 +1,230 @@
+// Copyright (©) 2024, Van Phan. All rights reserved.
+
+
+#include "Utility/ChessReplay.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/FileManager.h"
+#include "Async/MappedFileHandle.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+static_assert(PLATFORM_LITTLE_ENDIAN, "Replay records are read and written in place as little endian");
+
+namespace
+{
+    template<typename T>
+    void WriteValue(uint8*& Cursor, T Value)
+    {
+        FMemory::Memcpy(Cursor, &Value, sizeof(T));
+        Cursor += sizeof(T);
+    }
+
+    template<typename T>
+    T ReadValue(const uint8* Cursor)
+    {
+        T Value;
+        FMemory::Memcpy(&Value, Cursor, sizeof(T));
+        return Value;
+    }
+
+    // Two squares per byte, then side to move and castling, en passant, clocks
+    void PackSnapshot(const FChessPosition& Position, uint8 (&OutSnapshot)[ChessReplayFormat::SnapshotSize])
+    {
+        FMemory::Memzero(OutSnapshot);
+        uint8* Cursor = OutSnapshot;
+        for (int32 Square = 0; Square < 64; Square += 2)
+        {
+            WriteValue<uint8>(Cursor, (Position.Squares[Square] & 0x0F) | ((Position.Squares[Square + 1] & 0x0F) << 4));
+        }
+        WriteValue<uint8>(Cursor, (Position.bWhiteToMove ? 1 : 0) | ((Position.CastlingRights & 0x0F) << 1));
+        WriteValue<int8>(Cursor, Position.EnPassantSquare);
+        WriteValue<uint8>(Cursor, Position.HalfmoveClock);
+        WriteValue<uint8>(Cursor, 0);
+        WriteValue<uint16>(Cursor, Position.FullmoveNumber);
+    }
+
+    void UnpackSnapshot(const uint8* Snapshot, FChessPosition& OutPosition)
+    {
+        OutPosition.Clear();
+        for (int32 Square = 0; Square < 64; Square += 2)
+        {
+            OutPosition.Squares[Square] = Snapshot[Square / 2] & 0x0F;
+            OutPosition.Squares[Square + 1] = Snapshot[Square / 2] >> 4;
+        }
+        OutPosition.bWhiteToMove = (Snapshot[32] & 1) != 0;
+        OutPosition.CastlingRights = (Snapshot[32] >> 1) & 0x0F;
+        OutPosition.EnPassantSquare = ReadValue<int8>(Snapshot + 33);
+        OutPosition.HalfmoveClock = Snapshot[34];
+        OutPosition.FullmoveNumber = ReadValue<uint16>(Snapshot + 36);
+    }
+}
+
+FChessReplayWriter::~FChessReplayWriter()
+{
+    Close();
+}
+
+bool FChessReplayWriter::Open(const FString& Filename, const FChessReplayHeader& Header, const FChessPosition& StartPosition)
+{
+    Close();
+
+    IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+    PlatformFile.CreateDirectoryTree(*FPaths::GetPath(Filename));
+    FileHandle.Reset(PlatformFile.OpenWrite(*Filename, false, true)); // Shared for reading, viewers stream the replay while it's written
+    if (!FileHandle.IsValid())
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Couldn't open replay %s for writing"), *Filename);
+        return false;
+    }
+
+    WrittenHeader = Header;
+    WrittenHeader.SnapshotInterval = FMath::Max<uint16>(Header.SnapshotInterval, 1);
+    NumPlies = 0;
+
+    uint8 HeaderBytes[ChessReplayFormat::HeaderSize] = {};
+    uint8* Cursor = HeaderBytes;
+    WriteValue<uint32>(Cursor, ChessReplayFormat::Magic);
+    WriteValue<uint16>(Cursor, ChessReplayFormat::Version);
+    WriteValue<uint16>(Cursor, WrittenHeader.SnapshotInterval);
+    WriteValue<int32>(Cursor, WrittenHeader.MatchId);
+    WriteValue<int64>(Cursor, WrittenHeader.StartUnixTime);
+    if (!Write(HeaderBytes, ChessReplayFormat::HeaderSize)) return false;
+
+    uint8 Snapshot[ChessReplayFormat::SnapshotSize];
+    PackSnapshot(StartPosition, Snapshot);
+    return Write(Snapshot, ChessReplayFormat::SnapshotSize);
+}
+
+void FChessReplayWriter::AppendMove(uint16 Move, uint32 ClockMs, const FChessPosition& PositionAfterMove)
+{
+    if (!FileHandle.IsValid()) return;
+
+    uint8 Record[ChessReplayFormat::MoveRecordSize];
+    uint8* Cursor = Record;
+    WriteValue<uint16>(Cursor, Move);
+    WriteValue<uint32>(Cursor, ClockMs);
+    if (!Write(Record, ChessReplayFormat::MoveRecordSize)) return;
+    NumPlies++;
+
+    // Each full block is followed by the snapshot that opens the next one
+    if (NumPlies % WrittenHeader.SnapshotInterval == 0)
+    {
+        uint8 Snapshot[ChessReplayFormat::SnapshotSize];
+        PackSnapshot(PositionAfterMove, Snapshot);
+        if (!Write(Snapshot, ChessReplayFormat::SnapshotSize)) return;
+    }
+    FileHandle->Flush();
+}
+
+void FChessReplayWriter::Close()
+{
+    if (FileHandle.IsValid()) FileHandle->Flush();
+    FileHandle.Reset();
+}
+
+bool FChessReplayWriter::Write(const uint8* Bytes, int64 Size)
+{
+    if (!FileHandle.IsValid()) return false;
+    if (FileHandle->Write(Bytes, Size)) return true;
+
+    UE_LOG(LogTemp, Warning, TEXT("Replay write failed, recording stopped after %d plies"), NumPlies);
+    FileHandle.Reset();
+    return false;
+}
+
+FChessReplayReader::~FChessReplayReader()
+{
+    Close();
+}
+
+bool FChessReplayReader::Open(const FString& Filename)
+{
+    Close();
+
+    MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Filename));
+    if (MappedFile.IsValid() && MappedFile->GetFileSize() > 0)
+    {
+        MappedRegion.Reset(MappedFile->MapRegion(0, MappedFile->GetFileSize()));
+    }
+
+    if (MappedRegion.IsValid())
+    {
+        Data = MappedRegion->GetMappedPtr();
+        DataSize = MappedRegion->GetMappedSize();
+    }
+    else if (FFileHelper::LoadFileToArray(LoadedFile, *Filename))
+    {
+        Data = LoadedFile.GetData();
+        DataSize = LoadedFile.Num();
+    }
+
+    if (!Data || DataSize < ChessReplayFormat::HeaderSize + ChessReplayFormat::SnapshotSize
+        || ReadValue<uint32>(Data) != ChessReplayFormat::Magic || ReadValue<uint16>(Data + 4) != ChessReplayFormat::Version)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("%s isn't a chess replay this build can read"), *Filename);
+        Close();
+        return false;
+    }
+
+    Header.SnapshotInterval = FMath::Max<uint16>(ReadValue<uint16>(Data + 6), 1);
+    Header.MatchId = ReadValue<int32>(Data + 8);
+    Header.StartUnixTime = ReadValue<int64>(Data + 12);
+    return true;
+}
+
+void FChessReplayReader::Close()
+{
+    MappedRegion.Reset();
+    MappedFile.Reset();
+    LoadedFile.Empty();
+    Data = nullptr;
+    DataSize = 0;
+}
+
+int32 FChessReplayReader::GetNumPlies() const
+{
+    if (!Data) return 0;
+
+    // A trailing partial record is a move still being written, leave it out
+    const int64 BlockSize = ChessReplayFormat::GetBlockSize(Header.SnapshotInterval);
+    const int64 BodySize = DataSize - ChessReplayFormat::HeaderSize;
+    const int64 FullBlocks = BodySize / BlockSize;
+    const int64 MovesInLastBlock = FMath::Max<int64>(BodySize % BlockSize - ChessReplayFormat::SnapshotSize, 0) / ChessReplayFormat::MoveRecordSize;
+    return (int32)(FullBlocks * Header.SnapshotInterval + MovesInLastBlock);
+}
+
+int64 FChessReplayReader::GetMoveRecordOffset(int32 Ply) const
+{
+    const int32 Block = Ply / Header.SnapshotInterval;
+    return ChessReplayFormat::HeaderSize + Block * ChessReplayFormat::GetBlockSize(Header.SnapshotInterval)
+        + ChessReplayFormat::SnapshotSize + (Ply % Header.SnapshotInterval) * ChessReplayFormat::MoveRecordSize;
+}
+
+uint16 FChessReplayReader::GetMove(int32 Ply) const
+{
+    if (Ply < 0 || Ply >= GetNumPlies()) return ChessMove::None;
+    return ReadValue<uint16>(Data + GetMoveRecordOffset(Ply));
+}
+
+uint32 FChessReplayReader::GetClockMs(int32 Ply) const
+{
+    if (Ply < 0 || Ply >= GetNumPlies()) return 0;
+    return ReadValue<uint32>(Data + GetMoveRecordOffset(Ply) + sizeof(uint16));
+}
+
+bool FChessReplayReader::GetPositionAtPly(int32 Ply, FChessPosition& OutPosition) const
+{
+    if (!Data || Ply < 0 || Ply > GetNumPlies()) return false;
+
+    // The snapshot opening a block is the position before its first move
+    const int32 Block = Ply / Header.SnapshotInterval;
+    const int64 SnapshotOffset = ChessReplayFormat::HeaderSize + Block * ChessReplayFormat::GetBlockSize(Header.SnapshotInterval);
+    if (SnapshotOffset + ChessReplayFormat::SnapshotSize > DataSize) return false;
+    UnpackSnapshot(Data + SnapshotOffset, OutPosition);
+
+    for (int32 MovePly = Block * Header.SnapshotInterval; MovePly < Ply; MovePly++)
+    {
+        if (!OutPosition.ApplyMove(GetMove(MovePly))) return false;
+    }
+    return true;
+}
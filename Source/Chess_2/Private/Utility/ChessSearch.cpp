@@ -0,0 +1,213 @@
+// Copyright (©) 2024, Van Phan. All rights reserved.
+
+
+#include "Utility/ChessSearch.h"
+#include "HAL/PlatformTime.h"
+
+namespace
+{
+    // Indexed by piece type
+    const int32 PieceValues[8] = { 0, 100, 320, 330, 500, 900, 0, 0 };
+
+    // Small pulls towards the centre for pieces and up the board for pawns, from white's side
+    int32 GetPlacementBonus(uint8 Type, int32 File, int32 Rank)
+    {
+        const int32 CentreDistance = FMath::Max(FMath::Abs(2 * File - 7), FMath::Abs(2 * Rank - 7)); // 1 in the centre, 7 on the edge
+        switch (Type)
+        {
+            case ChessPiece::Pawn:   return Rank * 6 + (File >= 2 && File <= 5 ? Rank * 2 : 0);
+            case ChessPiece::Knight: return 20 - CentreDistance * 5;
+            case ChessPiece::Bishop: return 10 - CentreDistance * 2;
+            case ChessPiece::Queen:  return 4 - CentreDistance;
+            case ChessPiece::King:   return Rank == 0 ? 10 : -Rank * 8; // Kept home until the ending, good enough for puzzles and hints
+            default:                 return 0;
+        }
+    }
+
+    constexpr int32 Infinity = FChessSearch::MateScore + 1;
+}
+
+FChessSearchResult FChessSearch::Search(const FChessPosition& Root, const FChessSearchLimits& InLimits, const std::atomic<bool>* Stop, TFunction<void(const FChessSearchResult&)> OnDepthCompleted)
+{
+    Limits = InLimits;
+    ExternalStop = Stop;
+    StartTime = FPlatformTime::Seconds();
+    Nodes = 0;
+    bStopped = false;
+    FMemory::Memzero(PreviousPv, sizeof(PreviousPv));
+
+    FChessSearchResult Result;
+    FChessMoveList RootMoves;
+    FChessMoveGenerator::GenerateLegalMoves(Root, RootMoves);
+    if (RootMoves.IsEmpty()) return Result;
+
+    // Something to play even if the first depth never finishes
+    Result.BestMove = RootMoves[0];
+    const int32 NumLines = FMath::Clamp(Limits.MultiPV, 1, RootMoves.Num());
+
+    for (int32 Depth = 1; Depth <= FMath::Min(Limits.MaxDepth, MaxPly - 1); Depth++)
+    {
+        TArray<FChessSearchLine> DepthLines;
+        TArray<uint16> ExcludedMoves;
+
+        for (int32 LineIndex = 0; LineIndex < NumLines && !bStopped; LineIndex++)
+        {
+            // Last depth's lines go first, they are the most likely to still be best
+            OrderMoves(Root, RootMoves, LineIndex < Result.Lines.Num() ? Result.Lines[LineIndex].Moves[0] : PreviousPv[0]);
+
+            FChessSearchLine BestLine;
+            BestLine.Score = -Infinity;
+            for (uint16 Move : RootMoves)
+            {
+                if (ExcludedMoves.Contains(Move)) continue;
+
+                FChessPosition Child = Root;
+                Child.ApplyMove(Move);
+                TArray<uint16> ChildLine;
+                const int32 Score = -Negamax(Child, Depth - 1, -Infinity, -BestLine.Score, 1, ChildLine);
+                if (bStopped) break;
+
+                if (Score > BestLine.Score)
+                {
+                    BestLine.Score = Score;
+                    BestLine.Moves.Reset();
+                    BestLine.Moves.Add(Move);
+                    BestLine.Moves.Append(ChildLine);
+                }
+            }
+
+            if (bStopped || BestLine.Moves.IsEmpty()) break;
+            ExcludedMoves.Add(BestLine.Moves[0]);
+            DepthLines.Add(MoveTemp(BestLine));
+        }
+
+        // A depth cut short is thrown away, its moves were only compared against part of the list
+        if (DepthLines.Num() < NumLines) break;
+
+        Result.Lines = MoveTemp(DepthLines);
+        Result.BestMove = Result.Lines[0].Moves[0];
+        Result.Score = Result.Lines[0].Score;
+        Result.Depth = Depth;
+        Result.Nodes = Nodes;
+        Result.Seconds = FPlatformTime::Seconds() - StartTime;
+
+        FMemory::Memzero(PreviousPv, sizeof(PreviousPv));
+        for (int32 Ply = 0; Ply < Result.Lines[0].Moves.Num() && Ply < MaxPly; Ply++) PreviousPv[Ply] = Result.Lines[0].Moves[Ply];
+
+        if (OnDepthCompleted) OnDepthCompleted(Result);
+        if (IsMateScore(Result.Score) && NumLines == 1) break; // Nothing deeper will change a forced mate
+    }
+
+    Result.Nodes = Nodes;
+    Result.Seconds = FPlatformTime::Seconds() - StartTime;
+    return Result;
+}
+
+int32 FChessSearch::Negamax(const FChessPosition& Position, int32 Depth, int32 Alpha, int32 Beta, int32 Ply, TArray<uint16>& OutLine)
+{
+    if (ShouldStop()) return 0;
+
+    const bool bInCheck = FChessMoveGenerator::IsInCheck(Position);
+    if (bInCheck) Depth++; // Checks are searched one deeper so mates in the tree aren't cut off at the horizon
+    if (Depth <= 0 || Ply >= MaxPly - 1) return Quiesce(Position, Alpha, Beta, Ply);
+
+    Nodes++;
+    if (Position.HalfmoveClock >= 100) return 0;
+
+    FChessMoveList Moves;
+    FChessMoveGenerator::GenerateLegalMoves(Position, Moves);
+    if (Moves.IsEmpty()) return bInCheck ? -(MateScore - Ply) : 0;
+
+    OrderMoves(Position, Moves, PreviousPv[Ply]);
+
+    TArray<uint16> ChildLine;
+    for (uint16 Move : Moves)
+    {
+        FChessPosition Child = Position;
+        Child.ApplyMove(Move);
+        ChildLine.Reset();
+        const int32 Score = -Negamax(Child, Depth - 1, -Beta, -Alpha, Ply + 1, ChildLine);
+        if (bStopped) return 0;
+
+        if (Score > Alpha)
+        {
+            Alpha = Score;
+            OutLine.Reset();
+            OutLine.Add(Move);
+            OutLine.Append(ChildLine);
+            if (Alpha >= Beta) break;
+        }
+    }
+    return Alpha;
+}
+
+int32 FChessSearch::Quiesce(const FChessPosition& Position, int32 Alpha, int32 Beta, int32 Ply)
+{
+    if (ShouldStop()) return 0;
+    Nodes++;
+
+    const int32 StandPat = Evaluate(Position);
+    if (StandPat >= Beta || Ply >= MaxPly - 1) return StandPat;
+    Alpha = FMath::Max(Alpha, StandPat);
+
+    FChessMoveList Captures;
+    FChessMoveGenerator::GenerateLegalCaptures(Position, Captures);
+    OrderMoves(Position, Captures, ChessMove::None);
+
+    for (uint16 Move : Captures)
+    {
+        FChessPosition Child = Position;
+        Child.ApplyMove(Move);
+        const int32 Score = -Quiesce(Child, -Beta, -Alpha, Ply + 1);
+        if (bStopped) return 0;
+
+        if (Score >= Beta) return Score;
+        Alpha = FMath::Max(Alpha, Score);
+    }
+    return Alpha;
+}
+
+void FChessSearch::OrderMoves(const FChessPosition& Position, FChessMoveList& Moves, uint16 FirstMove) const
+{
+    // Most valuable victim, least valuable attacker, promotions alongside captures
+    auto GetOrderScore = [&Position, FirstMove](uint16 Move)
+    {
+        if (Move == FirstMove) return 100000;
+        const int32 Victim = PieceValues[ChessPiece::GetType(Position.Squares[ChessMove::GetTo(Move)])];
+        const int32 Attacker = ChessPiece::GetType(Position.Squares[ChessMove::GetFrom(Move)]);
+        const int32 Promotion = PieceValues[ChessMove::GetPromotion(Move)];
+        return (Victim + Promotion) * 10 - (Victim > 0 ? Attacker : 0);
+    };
+    Moves.StableSort([&GetOrderScore](uint16 A, uint16 B) { return GetOrderScore(A) > GetOrderScore(B); });
+}
+
+bool FChessSearch::ShouldStop()
+{
+    if (bStopped) return true;
+    if (Limits.NodeLimit > 0 && Nodes >= Limits.NodeLimit) bStopped = true;
+
+    // The clock and the other threads are only looked at every so often
+    else if ((Nodes & 1023) == 0)
+    {
+        bStopped = (ExternalStop && ExternalStop->load(std::memory_order_relaxed))
+            || (Limits.TimeLimitSeconds > 0.0 && FPlatformTime::Seconds() - StartTime >= Limits.TimeLimitSeconds);
+    }
+    return bStopped;
+}
+
+int32 FChessSearch::Evaluate(const FChessPosition& Position)
+{
+    int32 Score = 0;
+    for (int32 Square = 0; Square < 64; Square++)
+    {
+        const uint8 Code = Position.Squares[Square];
+        if (Code == ChessPiece::None) continue;
+
+        const uint8 Type = ChessPiece::GetType(Code);
+        const bool bBlack = ChessPiece::IsBlack(Code);
+        const int32 Rank = FChessPosition::GetRank(Square);
+        const int32 PieceScore = PieceValues[Type] + GetPlacementBonus(Type, FChessPosition::GetFile(Square), bBlack ? 7 - Rank : Rank);
+        Score += bBlack ? -PieceScore : PieceScore;
+    }
+    return Position.bWhiteToMove ? Score : -Score;
+}
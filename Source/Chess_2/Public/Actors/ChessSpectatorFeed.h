@@ -0,0 +1,61 @@
+// Copyright (©) 2024, Van Phan. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "Utility/ChessPosition.h"
+#include "ChessSpectatorFeed.generated.h"
+
+// A move waiting out the spectator delay on the server
+struct FChessDelayedMove
+{
+	double ReleaseTime = 0.0;
+	int32 Sequence = 0;
+	uint16 Move = ChessMove::None;
+};
+
+/**
+ * Everything spectators of one match receive: the position and the last few moves, held back by Chess.SpectatorDelay.
+ * Spawned by its board on the server, spectators never receive the board, squares or pieces themselves
+ */
+UCLASS()
+class CHESS_2_API AChessSpectatorFeed : public AActor
+{
+	GENERATED_BODY()
+	
+public:	
+	AChessSpectatorFeed();
+
+	void ResetFeed(class AChessBoard* NewBoard, const FChessPosition& StartPosition); // New game on the board
+	void RecordMove(int32 Sequence, uint16 Move); // Queued until the delay runs out
+
+protected:
+	virtual void Tick(float DeltaTime) override;
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+	virtual bool IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const override;
+
+private:
+	UPROPERTY(VisibleAnywhere, Replicated, meta=(AllowPrivateAccess="true"))
+	class AChessBoard* Board;
+
+	UPROPERTY(VisibleAnywhere, ReplicatedUsing=OnRep_Feed, meta=(AllowPrivateAccess="true"))
+	FChessPosition DelayedPosition;
+
+	UPROPERTY(VisibleAnywhere, ReplicatedUsing=OnRep_Feed, meta=(AllowPrivateAccess="true"))
+	int32 DelayedSequence = 0; // Moves DelayedPosition has had played on it
+
+	UPROPERTY(VisibleAnywhere, ReplicatedUsing=OnRep_Feed, meta=(AllowPrivateAccess="true"))
+	TArray<uint16> RecentMoves; // Last moves up to DelayedSequence, lets spectators animate instead of snapping
+
+	UFUNCTION()
+	void OnRep_Feed();
+
+	TArray<FChessDelayedMove> PendingMoves;
+
+public:
+	FORCEINLINE AChessBoard* GetBoard() const { return Board; } 
+	FORCEINLINE const FChessPosition& GetDelayedPosition() const { return DelayedPosition; } 
+	FORCEINLINE int32 GetDelayedSequence() const { return DelayedSequence; } 
+
+};
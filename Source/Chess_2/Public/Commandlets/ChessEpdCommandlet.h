@@ -0,0 +1,24 @@
+// Copyright (©) 2024, Van Phan. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ChessEpdCommandlet.generated.h"
+
+/**
+ * Runs FChessSearch over an EPD test suite (WAC, STS, ...) and reports solved count, time to solution and NPS.
+ * The file is streamed a line at a time and only as many positions as there are workers are held at once
+ *
+ * UnrealEditor-Cmd Chess_2.uproject -run=ChessEpd -File=Suites/wac.epd [-MoveTime=1000] [-Nodes=0] [-Threads=N]
+ */
+UCLASS()
+class CHESS_2_API UChessEpdCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UChessEpdCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
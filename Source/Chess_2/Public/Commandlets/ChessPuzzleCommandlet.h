@@ -0,0 +1,25 @@
+// Copyright (©) 2024, Van Phan. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ChessPuzzleCommandlet.generated.h"
+
+/**
+ * Builds the puzzle database from a Lichess puzzle export (PuzzleId,FEN,Moves,Rating,...,Themes,...). The export's
+ * first move is the opponent's, it is played into the stored FEN so every puzzle starts with the solver to move.
+ * Puzzles whose moves aren't legal or don't fit the format are dropped
+ *
+ * UnrealEditor-Cmd Chess_2.uproject -run=ChessPuzzle -In=lichess_db_puzzle.csv [-Out=Content/Puzzles/Puzzles.chesspuzzles]
+ */
+UCLASS()
+class CHESS_2_API UChessPuzzleCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UChessPuzzleCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
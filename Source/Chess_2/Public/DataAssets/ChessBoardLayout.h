@@ -0,0 +1,61 @@
+// Copyright (©) 2024, Van Phan. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "Utility/ChessPosition.h"
+#include "ChessBoardLayout.generated.h"
+
+/**
+ * Everything a board needs to build itself: where its squares go, which classes to spawn and the position to start from.
+ * Squares are laid out in board space, files along X and ranks along Y starting from A1
+ */
+UCLASS(BlueprintType)
+class CHESS_2_API UChessBoardLayout : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditDefaultsOnly, Category = "Squares")
+	TSubclassOf<class ABoardSquare> SquareClass;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Squares")
+	float SquareSize = 100.0f; // Distance between neighbouring square centres
+
+	UPROPERTY(EditDefaultsOnly, Category = "Squares")
+	FVector A1Offset = FVector(-350.0f, -350.0f, 0.0f); // Centre of A1 from the board's origin
+
+	UPROPERTY(EditDefaultsOnly, Category = "Chess Pieces")
+	TSubclassOf<class ABaseChessPiece> PawnPieceClass;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Chess Pieces")
+	TSubclassOf<class ABaseChessPiece> KnightPieceClass;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Chess Pieces")
+	TSubclassOf<class ABaseChessPiece> BishopPieceClass;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Chess Pieces")
+	TSubclassOf<class ABaseChessPiece> RookPieceClass;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Chess Pieces")
+	TSubclassOf<class ABaseChessPiece> QueenPieceClass;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Chess Pieces")
+	TSubclassOf<class ABaseChessPiece> KingPieceClass;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Chess Pieces")
+	float PieceHeight = 0.0f; // Above the square's origin
+
+	UPROPERTY(EditDefaultsOnly, Category = "Chess Pieces")
+	FRotator WhitePieceRotation = FRotator::ZeroRotator; // Relative to the board
+
+	UPROPERTY(EditDefaultsOnly, Category = "Chess Pieces")
+	FRotator BlackPieceRotation = FRotator(0.0f, 180.0f, 0.0f);
+
+	UPROPERTY(EditDefaultsOnly, Category = "Setup")
+	FString StartFen = FChessPosition::StartFen;
+
+	TSubclassOf<class ABaseChessPiece> GetPieceClass(uint8 PieceType) const; // One of the ChessPiece codes
+	FVector GetSquareOffset(int32 SquareIndex) const; // 0 = A1, 63 = H8
+};
@@ -0,0 +1,59 @@
+// Copyright (©) 2024, Van Phan. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameModes/ChessGameMode.h"
+#include "Utility/ChessPuzzleDatabase.h"
+#include "UObject/ObjectKey.h"
+#include "ChessPuzzleGameMode.generated.h"
+
+/**
+ * Tactics puzzles from the mapped puzzle database, each player alone on a board. Open the level with
+ * ?game=<this mode>?MinRating=1200?MaxRating=1800?Theme=fork (any theme when left out). The solver plays the side
+ * to move, replies are played for them and a wrong move is taken back to try again
+ */
+UCLASS()
+class CHESS_2_API AChessPuzzleGameMode : public AChessGameMode
+{
+	GENERATED_BODY()
+
+public:
+	virtual void InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage) override;
+	virtual void PlayerReady(class AChessPlayer* Player) override;
+	virtual void EndTurn(class AChessBoard* ChessBoard) override;
+
+	UFUNCTION(Exec)
+	void NextPuzzle(); // Every solver moves on to a new puzzle
+
+protected:
+	virtual void Logout(AController* Exiting) override;
+
+private:
+	struct FChessPuzzleAttempt
+	{
+		TWeakObjectPtr<class AChessPlayer> Solver;
+		FChessPuzzle Puzzle;
+		FChessPosition Position; // Where the solver's next move is played from
+		int32 Ply = 0; // Next solution move the solver has to find
+		int32 HandledSequence = 0; // Castling ends the turn twice, a move is only judged once
+		int32 PuzzleNumber = 0; // Delayed callbacks for an earlier puzzle check this and do nothing
+		int32 Mistakes = 0;
+	};
+
+	UPROPERTY(EditDefaultsOnly, Category = "Puzzles")
+	float ReplyDelay = 0.5f; // Seconds the solver's move stays up before the reply or the take back
+
+	UPROPERTY(EditDefaultsOnly, Category = "Puzzles")
+	float NextPuzzleDelay = 2.0f;
+
+	int32 MinRating = 0;
+	int32 MaxRating = MAX_uint16;
+	int32 Theme = INDEX_NONE;
+
+	TMap<TObjectKey<class AChessBoard>, FChessPuzzleAttempt> Attempts;
+
+	void StartPuzzle(class AChessBoard* ChessBoard, class AChessPlayer* Solver);
+	void ShowAttemptPosition(class AChessBoard* ChessBoard, int32 PuzzleNumber, float Delay); // The board snaps to the attempt's position after Delay
+	void HandleBoardReady(class AChessBoard* ChessBoard);
+};
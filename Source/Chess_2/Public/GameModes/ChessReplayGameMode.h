@@ -0,0 +1,58 @@
+// Copyright (©) 2024, Van Phan. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameModes/ChessGameMode.h"
+#include "Utility/ChessReplay.h"
+#include "ChessReplayGameMode.generated.h"
+
+/**
+ * Plays a recorded match back on the Game level's board instead of hosting one. Open the level with
+ * ?game=<this mode>?Replay=<file in Saved/Replays> (newest replay when left out), viewers get the observation pawn.
+ * Moves only drive the pieces' visuals, nothing is validated and piece physics is switched off
+ */
+UCLASS()
+class CHESS_2_API AChessReplayGameMode : public AChessGameMode
+{
+	GENERATED_BODY()
+
+public:
+	AChessReplayGameMode();
+
+	virtual void InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage) override;
+	virtual void StartPlay() override;
+	virtual void Tick(float DeltaSeconds) override;
+	virtual void PlayerReady(class AChessPlayer* Player) override {} // Viewers never queue for a match
+
+	// Negative plays backwards, the magnitude is clamped to 1x - 64x
+	UFUNCTION(Exec)
+	void ReplaySpeed(float NewSpeed);
+
+	UFUNCTION(Exec)
+	void ReplaySeek(int32 Ply);
+
+	UFUNCTION(Exec)
+	void ReplayPause();
+
+protected:
+	virtual void PostLogin(APlayerController* NewPlayer) override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	UPROPERTY()
+	class AChessBoard* ReplayBoard;
+
+	FChessReplayReader Reader;
+	FString ReplayFilename;
+
+	int32 CurrentPly = 0; // Moves shown on the board
+	double PlaybackTimeMs = 0.0; // Position in the recorded game's clock
+	float PlaybackSpeed = 1.0f;
+	bool bPaused = false;
+
+	void AddViewer(APlayerController* Viewer);
+	void SeekToPly(int32 Ply); // Nearest snapshot, so any ply costs the same
+	void StepForward();
+	static FString FindNewestReplay();
+};
@@ -0,0 +1,35 @@
+// Copyright (©) 2024, Van Phan. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameModes/ChessGameMode.h"
+#include "ChessSimulGameMode.generated.h"
+
+/**
+ * Simultaneous exhibition, one exhibitor against everyone else with a board each. The first player ready becomes
+ * the exhibitor and plays white on every board. After each turn the exhibitor is taken to the next board waiting
+ * on them, the way they would walk round the ring of tables
+ */
+UCLASS()
+class CHESS_2_API AChessSimulGameMode : public AChessGameMode
+{
+	GENERATED_BODY()
+
+public:
+	virtual void PlayerReady(class AChessPlayer* Player) override;
+	virtual void EndTurn(class AChessBoard* ChessBoard) override;
+	virtual void MatchEnded(class AChessBoard* ChessBoard) override;
+
+protected:
+	virtual void Logout(AController* Exiting) override;
+	virtual class AChessPlayer* GetTravellingPlayer(const struct FChessMatch& Match) const override;
+	virtual void MatchStarted(class AChessBoard* ChessBoard) override;
+
+private:
+	UPROPERTY()
+	class AChessPlayer* Exhibitor;
+
+	void MoveExhibitorToNextBoard(); // Stays put while the board in front of them still waits on their move
+	void MoveExhibitorTo(class AChessBoard* ChessBoard);
+};
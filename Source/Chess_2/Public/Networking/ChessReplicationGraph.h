@@ -0,0 +1,83 @@
+// Copyright (©) 2024, Van Phan. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ReplicationGraph.h"
+#include "UObject/ObjectKey.h"
+#include "ChessReplicationGraph.generated.h"
+
+// Everything replicated for one match, shared by every connection that receives it
+struct FChessMatchReplicationLists
+{
+	FActorRepListRefView PlayerActors; // Board, squares, pieces, player pawns and the two players' states
+	FActorRepListRefView SpectatorActors; // Just the spectator feed
+};
+
+/**
+ * Hands each connection the lists of the match it plays or watches. Spectators of a match all share one list
+ * and are spread over Chess.SpectatorBuckets frames, so adding a spectator adds no per actor work
+ */
+UCLASS()
+class CHESS_2_API UChessReplicationGraphNode_Matches : public UReplicationGraphNode
+{
+	GENERATED_BODY()
+
+public:
+	UChessReplicationGraphNode_Matches();
+
+	virtual void NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo) override;
+	virtual bool NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound = true) override;
+	virtual void NotifyResetAllNetworkActors() override;
+	virtual void PrepareForReplication() override;
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+	FORCEINLINE void MarkMatchListsDirty() { bMatchListsDirty = true; }
+
+private:
+	void RebuildMatchLists();
+	static class AChessBoard* FindBoardForActor(const AActor* Actor);
+
+	FActorRepListRefView MatchActors; // Every actor routed here, sorted into MatchLists on rebuild
+	TMap<TObjectKey<class AChessBoard>, FChessMatchReplicationLists> MatchLists;
+	bool bMatchListsDirty = true;
+};
+
+// The connection's own controller, pawn and player state
+UCLASS()
+class CHESS_2_API UChessReplicationGraphNode_AlwaysRelevantForConnection : public UReplicationGraphNode_AlwaysRelevant_ForConnection
+{
+	GENERATED_BODY()
+
+public:
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+};
+
+/**
+ * Replaces per actor relevancy checks with per match lists. Enabled through ReplicationDriverClassName in DefaultEngine.ini,
+ * without it the IsNetRelevantFor overrides on the board actors give the same result at a higher cost
+ */
+UCLASS(transient, config=Engine)
+class CHESS_2_API UChessReplicationGraph : public UReplicationGraph
+{
+	GENERATED_BODY()
+
+public:
+	virtual void InitGlobalActorClassSettings() override;
+	virtual void InitGlobalGraphNodes() override;
+	virtual void InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection) override;
+	virtual void RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo) override;
+	virtual void RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo) override;
+
+	// Call when an actor's board changes after it was added, a player paired or a feed reset. Does nothing without the graph
+	static void NotifyMatchesChanged(const UWorld* World);
+
+private:
+	UPROPERTY()
+	UReplicationGraphNode_ActorList* AlwaysRelevantNode; // Game state and anything else everyone needs
+
+	UPROPERTY()
+	UChessReplicationGraphNode_Matches* MatchesNode;
+
+	static bool IsMatchActor(const AActor* Actor);
+	static bool IsConnectionActor(const AActor* Actor); // Only its owner's connection gathers it
+};
@@ -0,0 +1,82 @@
+// Copyright (©) 2024, Van Phan. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Utility/ChessSearch.h"
+#include "ChessAnalysisSubsystem.generated.h"
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnChessAnalysisUpdatedSignature, const FChessPosition& /*Position*/, const FChessSearchResult& /*Result*/);
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnChessHintReadySignature, uint64 /*PositionHash*/, uint16 /*Move*/);
+
+/**
+ * Searches a board's position on a background thread pool for as long as analysis is on. The game thread only
+ * hashes the position each frame to notice moves and copies the latest lines out a few times a second
+ */
+UCLASS()
+class CHESS_2_API UChessAnalysisSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	static constexpr float UpdateInterval = 0.25f; // Seconds between OnAnalysisUpdated broadcasts at most
+	static constexpr int32 MaxCachedHints = 4096;
+
+	// Follows the board until StopAnalysis, a new position stops the running search and queues another
+	void StartAnalysis(const class AChessBoard* Board, int32 NumLines);
+	void StopAnalysis();
+	FORCEINLINE bool IsAnalysing() const { return AnalysedBoard.IsValid(); }
+
+	// Best move for the board's side to move within the time budget. Answers are cached by position hash so asking again
+	// broadcasts OnHintReady straight away, ChessMove::None when there's nothing to play
+	void RequestHint(const class AChessBoard* Board, float TimeBudgetSeconds);
+
+	// Background searches queue here by priority: High for opponents, Normal for analysis, Low for hints
+	FQueuedThreadPool* GetSearchThreadPool() const { return SearchThreadPool; }
+
+	FOnChessAnalysisUpdatedSignature OnAnalysisUpdated;
+	FOnChessHintReadySignature OnHintReady;
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	// Shared between the game thread and the search working on it, a restart just abandons the old one
+	struct FAnalysisJob
+	{
+		FChessPosition Position;
+		std::atomic<bool> bStop { false };
+		FCriticalSection ResultLock;
+		FChessSearchResult LatestResult;
+		bool bHasNewResult = false;
+	};
+
+	struct FHintJob
+	{
+		FChessPosition Position;
+		std::atomic<bool> bStop { false };
+		std::atomic<bool> bDone { false };
+		uint16 Move = ChessMove::None; // Written by the search before bDone is set
+	};
+
+	TWeakObjectPtr<const class AChessBoard> AnalysedBoard;
+	int32 AnalysedLines = 1;
+	uint64 AnalysedHash = 0;
+	TSharedPtr<FAnalysisJob, ESPMode::ThreadSafe> CurrentJob;
+	float TimeSinceUpdate = 0.0f;
+
+	TMap<uint64, uint16> HintCache;
+	TMap<uint64, TSharedPtr<FHintJob, ESPMode::ThreadSafe>> PendingHints; // A second request for the same position waits on the first
+
+	FQueuedThreadPool* SearchThreadPool = nullptr;
+
+	void CollectHints();
+	void RestartJob(const FChessPosition& Position);
+	void StopJob();
+};
@@ -0,0 +1,81 @@
+// Copyright (©) 2024, Van Phan. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "ChessMatchSubsystem.generated.h"
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnChessMatchPairedSignature, int32 /*MatchId*/);
+
+USTRUCT()
+struct FChessMatch
+{
+	GENERATED_BODY();
+
+public:
+	UPROPERTY()
+	int32 MatchId = INDEX_NONE;
+
+	UPROPERTY()
+	class AChessBoard* Board = nullptr;
+
+	UPROPERTY()
+	class AChessPlayer* WhitePlayer = nullptr;
+
+	UPROPERTY()
+	class AChessPlayer* BlackPlayer = nullptr;
+
+	FORCEINLINE bool HasPlayers() const { return WhitePlayer || BlackPlayer; }
+};
+
+/**
+ * Server side registry of every match in the world. Each board is one match, players are paired onto free boards
+ * and anything a player sends the server is routed to their match through here. A player can be in any number of
+ * matches, in a simul one player takes a side on every board
+ */
+UCLASS()
+class CHESS_2_API UChessMatchSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	int32 RegisterBoard(class AChessBoard* Board); // Returns the match id the board now hosts
+	void UnregisterBoard(class AChessBoard* Board);
+
+	int32 QueuePlayer(class AChessPlayer* Player); // Returns the match id once the player has an opponent and a free board, INDEX_NONE while waiting
+	void RemovePlayer(class AChessPlayer* Player);
+	int32 StartSoloMatch(class AChessPlayer* Player); // Puts the player alone on a free board for modes without an opponent, INDEX_NONE if every board is taken
+	int32 PairOnFreeBoard(class AChessPlayer* WhitePlayer, class AChessPlayer* BlackPlayer); // Either player may already be in other matches, INDEX_NONE if every board is taken
+	// Takes the player off the match's board, ending the game for their opponent if it was still going. Once nobody
+	// is left the board is free and waiting players are paired onto it. Players stay at a finished game to see the result
+	void LeaveMatch(class AChessPlayer* Player, int32 MatchId);
+	void LeaveFinishedMatches(class AChessPlayer* Player); // Before the player queues again
+
+	// Waiting players paired later, when a board registered or was left. QueuePlayer returns its pairings instead
+	FOnChessMatchPairedSignature OnMatchPaired;
+
+	FChessMatch* FindMatch(int32 MatchId);
+	FChessMatch* FindMatchForPlayer(const class AController* Player); // The match at the board the player's pawn stands at, else their first
+	class AChessBoard* FindBoardForPlayer(const class AController* Player);
+	void GetMatchesForPlayer(const class AController* Player, TArray<FChessMatch*>& OutMatches);
+
+	class AChessBoard* FindBoardToSpectate(int32 MatchId); // That match's board, or the first match being played when it doesn't exist
+
+	FORCEINLINE int32 GetNumMatches() const { return Matches.Num(); }
+
+private:
+	UPROPERTY()
+	TMap<int32, FChessMatch> Matches;
+
+	UPROPERTY()
+	TArray<class AChessPlayer*> WaitingPlayers;
+
+	// Lets RPCs find their match without walking every match
+	TMultiMap<TObjectKey<class AController>, int32> PlayerMatchIds;
+
+	int32 NextMatchId = 0;
+
+	void PairWaitingPlayers();
+};
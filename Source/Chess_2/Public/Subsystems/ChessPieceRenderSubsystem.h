@@ -0,0 +1,44 @@
+// Copyright (©) 2024, Van Phan. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "ChessPieceRenderSubsystem.generated.h"
+
+/**
+ * Draws every resting chess piece in the world through one hierarchical instanced mesh per piece mesh, so a hall
+ * of boards costs a handful of draw calls. Instances are never removed, only scaled to nothing and reused,
+ * which keeps every piece's instance index stable
+ */
+UCLASS()
+class CHESS_2_API UChessPieceRenderSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// Per instance custom data the instanced materials read
+	static constexpr int32 TeamDataIndex = 0; // 0 white, 1 black
+	static constexpr int32 HighlightDataIndex = 1;
+	static constexpr int32 NumCustomData = 2;
+
+	int32 AddInstance(class UStaticMesh* Mesh, class UMaterialInterface* Material, const FTransform& Transform); // INDEX_NONE where nothing is rendered
+	void RemoveInstance(class UStaticMesh* Mesh, int32 Instance);
+	void UpdateInstance(class UStaticMesh* Mesh, int32 Instance, const FTransform& Transform, bool bVisible);
+	void SetInstanceData(class UStaticMesh* Mesh, int32 Instance, bool bBlack, bool bHighlighted);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	UPROPERTY()
+	AActor* InstanceActor;
+
+	UPROPERTY()
+	TMap<class UStaticMesh*, class UHierarchicalInstancedStaticMeshComponent*> Batches;
+
+	TMap<TObjectKey<class UStaticMesh>, TArray<int32>> FreeInstances;
+
+	class UHierarchicalInstancedStaticMeshComponent* FindOrAddBatch(class UStaticMesh* Mesh, class UMaterialInterface* Material);
+};
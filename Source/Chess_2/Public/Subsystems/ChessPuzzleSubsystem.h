@@ -0,0 +1,33 @@
+// Copyright (©) 2024, Van Phan. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Utility/ChessPuzzleDatabase.h"
+#include "ChessPuzzleSubsystem.generated.h"
+
+/**
+ * Maps the puzzle database once when the game starts and keeps it mapped for the whole session. Only the index pages
+ * a pick touches and the picked record are ever read, however many puzzles the file holds
+ */
+UCLASS()
+class CHESS_2_API UChessPuzzleSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	static constexpr int32 MaxPickAttempts = 8;
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// A random playable puzzle in the rating range, Theme is a ChessPuzzleTheme bit index or INDEX_NONE for any
+	bool PickPuzzle(int32 MinRating, int32 MaxRating, int32 Theme, FChessPuzzle& OutPuzzle);
+
+	FORCEINLINE const FChessPuzzleDatabase& GetDatabase() const { return Database; }
+
+private:
+	FChessPuzzleDatabase Database;
+	FRandomStream Random;
+};
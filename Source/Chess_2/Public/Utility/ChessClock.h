@@ -0,0 +1,55 @@
+// Copyright (©) 2024, Van Phan. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ChessClock.generated.h"
+
+/**
+ * Both players' clocks as replicated state, nothing ticks. The side to move has what it had when its turn started
+ * less the time since, so every peer that knows the server's time works out the same display. Times are server world
+ * seconds, AGameStateBase::GetServerWorldTimeSeconds on every peer
+ */
+USTRUCT()
+struct FChessClock
+{
+	GENERATED_BODY();
+
+public:
+	UPROPERTY()
+	int32 WhiteRemainingMs = 0; // As of TurnStartTime
+
+	UPROPERTY()
+	int32 BlackRemainingMs = 0;
+
+	UPROPERTY()
+	double TurnStartTime = 0.0;
+
+	UPROPERTY()
+	uint16 IncrementMs = 0; // Added after every move
+
+	UPROPERTY()
+	uint16 DelayMs = 0; // Free time at the start of every turn before the clock runs
+
+	UPROPERTY()
+	bool bWhiteToMove = true; // Kept with the times rather than read off the position, the two replicate separately
+
+	UPROPERTY()
+	bool bRunning = false;
+
+	FORCEINLINE bool IsEnabled() const { return WhiteRemainingMs > 0 || BlackRemainingMs > 0; }
+	FORCEINLINE bool IsFlagged(bool bWhite) const { return IsEnabled() && !bRunning && (bWhite ? WhiteRemainingMs : BlackRemainingMs) <= 0; }
+
+	void Start(int32 BaseMs, int32 InIncrementMs, int32 InDelayMs, bool bInWhiteToMove, double Now); // A base of zero leaves the clock off
+	void Stop(double Now); // Charges the side to move for its turn so far and freezes both clocks
+	void SetSideToMove(bool bInWhiteToMove, double Now); // For a position set mid game, charges the side leaving without an increment and starts the other's turn
+
+	// Charges the mover up to MoveTime, less LatencyCreditMs for the time the move spent in flight, and starts the other side's turn at Now. False if the mover ran out of time
+	bool Press(double MoveTime, double Now, int32 LatencyCreditMs);
+
+	int32 GetRemainingMs(bool bWhite, double Now) const; // Never below zero
+	double GetSecondsUntilFlag(double Now) const; // For the side to move
+
+private:
+	int32 GetChargedMs(double Until, int32 LatencyCreditMs) const; // Time of the current turn that counts, after the delay and the credit
+};
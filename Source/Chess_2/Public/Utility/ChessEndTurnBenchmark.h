@@ -0,0 +1,27 @@
+// Copyright (©) 2024, Van Phan. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FChessBenchmarkPosition
+{
+	FString Name;
+	FString Fen;
+	double BudgetMs = 0.0; // p99 EndTurn may take on this position before the run fails
+};
+
+/**
+ * Times AChessGameMode::EndTurn over a corpus of positions and writes p50/p99 per position to a CSV.
+ * The corpus and its budgets live in Config/Benchmarks. The Chess.Benchmarks.EndTurn automation test runs it headless with
+ * Chess_2 -game -nullrhi -unattended -ExecCmds="Automation RunTests Chess.Benchmarks.EndTurn; Quit", BenchmarkEndTurn runs it in a session
+ */
+class CHESS_2_API FChessEndTurnBenchmark
+{
+public:
+	static bool LoadCorpus(const FString& Filename, TArray<FChessBenchmarkPosition>& OutPositions); // One "Name | FEN | p99 budget in ms" per line, # comments
+	static bool Run(class AChessGameMode* GameMode, class AChessBoard* ChessBoard, int32 Iterations); // False if any position went over budget
+	static class AChessBoard* FindIdleBoard(class UWorld* World); // A ready board nobody is playing on, the benchmark sets it up and puts it back when done
+
+	static FString GetDefaultCorpusFilename();
+};
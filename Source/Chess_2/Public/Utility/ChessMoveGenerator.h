@@ -0,0 +1,37 @@
+// Copyright (©) 2024, Van Phan. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Utility/ChessPosition.h"
+
+// No position has more than 218 legal moves, so lists never leave the stack
+typedef TArray<uint16, TInlineAllocator<256>> FChessMoveList;
+
+/**
+ * Full chess rules on FChessPosition, independent of the board actors. Used by the search and anything
+ * that needs legal moves off the game thread
+ */
+class CHESS_2_API FChessMoveGenerator
+{
+public:
+	static void GenerateLegalMoves(const FChessPosition& Position, FChessMoveList& OutMoves);
+	static void GenerateLegalCaptures(const FChessPosition& Position, FChessMoveList& OutMoves); // Captures and promotions
+	static bool IsLegalMove(const FChessPosition& Position, uint16 Move);
+
+	static bool IsSquareAttacked(const FChessPosition& Position, int32 Square, bool bByWhite);
+	static bool IsInCheck(const FChessPosition& Position); // The side to move
+	static int32 FindKing(const FChessPosition& Position, bool bWhite); // INDEX_NONE without one
+	static bool IsCapture(const FChessPosition& Position, uint16 Move);
+	static uint64 Perft(const FChessPosition& Position, int32 Depth); // Leaf nodes of the legal move tree, checked against the published counts
+
+	// Standard algebraic notation, with + and # suffixes. ParseSan ignores suffixes and annotations, ChessMove::None when nothing legal matches
+	static FString MoveToSan(const FChessPosition& Position, uint16 Move);
+	static uint16 ParseSan(const FChessPosition& Position, const FString& San);
+	static FString MoveToUci(uint16 Move);
+	static uint16 ParseUci(const FChessPosition& Position, const FString& Uci);
+
+private:
+	static void GeneratePseudoLegalMoves(const FChessPosition& Position, FChessMoveList& OutMoves, bool bCapturesOnly);
+	static void FilterLegal(const FChessPosition& Position, FChessMoveList& Moves);
+};
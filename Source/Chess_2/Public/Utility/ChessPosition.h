@@ -0,0 +1,95 @@
+// Copyright (©) 2024, Van Phan. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ChessPosition.generated.h"
+
+// Piece codes stored per square, low three bits are the piece type and BlackFlag marks the team
+namespace ChessPiece
+{
+	constexpr uint8 None = 0;
+	constexpr uint8 Pawn = 1;
+	constexpr uint8 Knight = 2;
+	constexpr uint8 Bishop = 3;
+	constexpr uint8 Rook = 4;
+	constexpr uint8 Queen = 5;
+	constexpr uint8 King = 6;
+	constexpr uint8 TypeMask = 0x07;
+	constexpr uint8 BlackFlag = 0x08;
+
+	FORCEINLINE uint8 Make(uint8 Type, bool bBlack) { return Type | (bBlack ? BlackFlag : 0); }
+	FORCEINLINE uint8 GetType(uint8 Code) { return Code & TypeMask; }
+	FORCEINLINE bool IsBlack(uint8 Code) { return (Code & BlackFlag) != 0; }
+}
+
+namespace ChessCastling
+{
+	constexpr uint8 WhiteKingside = 1 << 0;
+	constexpr uint8 WhiteQueenside = 1 << 1;
+	constexpr uint8 BlackKingside = 1 << 2;
+	constexpr uint8 BlackQueenside = 1 << 3;
+}
+
+// Moves packed into 16 bits: from square, to square and the promotion piece type
+namespace ChessMove
+{
+	constexpr uint16 None = 0; // A1 to A1, never a real move
+
+	FORCEINLINE uint16 Make(int32 From, int32 To, uint8 Promotion = ChessPiece::None) { return (uint16)((From & 63) | ((To & 63) << 6) | ((Promotion & ChessPiece::TypeMask) << 12)); }
+	FORCEINLINE int32 GetFrom(uint16 Move) { return Move & 63; }
+	FORCEINLINE int32 GetTo(uint16 Move) { return (Move >> 6) & 63; }
+	FORCEINLINE uint8 GetPromotion(uint16 Move) { return (Move >> 12) & ChessPiece::TypeMask; }
+}
+
+/**
+ * Plain data copy of one match's board, squares indexed 0 = A1 to 63 = H8
+ */
+USTRUCT(BlueprintType)
+struct FChessPosition
+{
+	GENERATED_BODY();
+
+public:
+	FChessPosition() { Clear(); }
+
+	static constexpr const TCHAR* StartFen = TEXT("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+
+	UPROPERTY()
+	uint8 Squares[64];
+
+	UPROPERTY()
+	bool bWhiteToMove = true;
+
+	UPROPERTY()
+	uint8 CastlingRights = 0;
+
+	UPROPERTY()
+	int8 EnPassantSquare = INDEX_NONE; // Square a pawn can capture onto en passant, INDEX_NONE if there isn't one
+
+	UPROPERTY()
+	uint8 HalfmoveClock = 0; // Plies since the last capture or pawn move
+
+	UPROPERTY()
+	uint16 FullmoveNumber = 1;
+
+	void Clear();
+	int32 CountPieces() const;
+
+	// Plays a move without checking legality, castling, en passant and promotion included. False if there's nothing of the side to move on the from square
+	bool ApplyMove(uint16 Move);
+
+	// Zobrist key of the pieces, side to move, castling rights and en passant file. Keys come from a fixed seed so every peer agrees
+	uint64 ComputeHash() const;
+
+	// Placement and side to move are required, missing castling, en passant and clock fields take their defaults. Unchanged on false
+	bool SetFromFen(const FString& Fen);
+	FString ToFen() const;
+
+	static FORCEINLINE int32 MakeSquare(int32 File, int32 Rank) { return File + Rank * 8; } // Both zero based
+	static FORCEINLINE int32 GetFile(int32 Square) { return Square & 7; }
+	static FORCEINLINE int32 GetRank(int32 Square) { return Square >> 3; }
+
+	bool operator==(const FChessPosition& Other) const;
+	bool operator!=(const FChessPosition& Other) const { return !(*this == Other); }
+};
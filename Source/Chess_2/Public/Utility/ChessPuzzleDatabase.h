@@ -0,0 +1,75 @@
+// Copyright (©) 2024, Van Phan. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Utility/ChessPosition.h"
+
+/**
+ * Puzzle databases are built once by the ChessPuzzle commandlet and only ever read in place, little endian:
+ *   Header   144 bytes, magic "CHPZ", version, puzzle count, FEN bytes, then the length of each theme's index
+ *   Records  44 bytes each sorted by rating: FEN offset and length, rating, theme bits, up to MaxSolutionMoves moves
+ *   Themes   one list of record indices per theme in ascending order, so each one is sorted by rating too
+ *   FENs     every FEN back to back without terminators
+ * Picking a puzzle is a binary search over records or a theme's list, nothing but the pages touched is read
+ */
+namespace ChessPuzzleFormat
+{
+	constexpr uint32 Magic = 0x5A504843; // "CHPZ"
+	constexpr uint16 Version = 1;
+	constexpr int32 NumThemes = 32;
+	constexpr int32 MaxSolutionMoves = 16;
+	constexpr int64 HeaderSize = 16 + NumThemes * 4;
+	constexpr int64 RecordSize = 12 + MaxSolutionMoves * 2;
+}
+
+// Theme bits follow the Lichess puzzle tags, a theme is its bit index
+namespace ChessPuzzleTheme
+{
+	const TCHAR* GetName(int32 Theme);
+	int32 FindTheme(const FString& Name); // INDEX_NONE if it isn't one of the NumThemes
+}
+
+struct FChessPuzzle
+{
+	FString Fen;
+	TArray<uint16> Solution; // The solver's moves with the replies between them, starting with the solver's
+	uint16 Rating = 1500;
+	uint32 Themes = 0;
+
+	bool IsPlayable() const; // The FEN sets up and every solution move is legal where it's played
+};
+
+class CHESS_2_API FChessPuzzleDatabase
+{
+public:
+	~FChessPuzzleDatabase();
+
+	bool Open(const FString& Filename); // Fails if the file can't be memory mapped, it's never loaded whole
+	void Close();
+
+	// Uniform over the puzzles rated MinRating to MaxRating, limited to one theme unless Theme is INDEX_NONE. INDEX_NONE when none match
+	int32 PickRandom(int32 MinRating, int32 MaxRating, int32 Theme, FRandomStream& Random) const;
+	bool GetPuzzle(int32 Index, FChessPuzzle& OutPuzzle) const;
+
+	FORCEINLINE bool IsOpen() const { return Data != nullptr; }
+	FORCEINLINE int32 Num() const { return NumPuzzles; }
+
+	static bool Write(const FString& Filename, TArray<FChessPuzzle> Puzzles); // Puzzles that don't fit the format are left out
+	static FString GetDefaultFilename(); // Content/Puzzles/Puzzles.chesspuzzles, staged outside the pak so it can be mapped
+
+private:
+	uint16 GetRating(int32 Theme, int32 Entry) const;
+	int32 GetRecordIndex(int32 Theme, int32 Entry) const; // Entry in a theme's list, or the record itself for INDEX_NONE
+	int32 LowerBound(int32 Theme, int32 Rating) const; // First entry rated at least Rating
+
+	TUniquePtr<class IMappedFileHandle> MappedFile;
+	TUniquePtr<class IMappedFileRegion> MappedRegion;
+
+	const uint8* Data = nullptr;
+	int64 DataSize = 0;
+	int32 NumPuzzles = 0;
+	int64 ThemeListOffsets[ChessPuzzleFormat::NumThemes] = {};
+	int32 ThemeCounts[ChessPuzzleFormat::NumThemes] = {};
+	int64 FenOffset = 0;
+};
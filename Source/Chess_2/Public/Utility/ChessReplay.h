@@ -0,0 +1,81 @@
+// Copyright (©) 2024, Van Phan. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Utility/ChessPosition.h"
+
+/**
+ * Replay files are append only and little endian:
+ *   Header   32 bytes, magic "CHRP", version, snapshot interval N, match id, start time
+ *   Block    40 byte position snapshot, then up to N move records of 6 bytes (16 bit move, 32 bit ms since the game started)
+ * Every block but the last is full, so the snapshot before any ply is found with arithmetic alone
+ * and a file still being written can be read up to its last complete record
+ */
+namespace ChessReplayFormat
+{
+	constexpr uint32 Magic = 0x50524843; // "CHRP"
+	constexpr uint16 Version = 1;
+	constexpr int64 HeaderSize = 32;
+	constexpr int64 SnapshotSize = 40;
+	constexpr int64 MoveRecordSize = 6;
+
+	FORCEINLINE int64 GetBlockSize(int32 SnapshotInterval) { return SnapshotSize + SnapshotInterval * MoveRecordSize; }
+}
+
+struct FChessReplayHeader
+{
+	uint16 SnapshotInterval = 16;
+	int32 MatchId = INDEX_NONE;
+	int64 StartUnixTime = 0;
+};
+
+// Streams one game to disk as it is played, every record is flushed as soon as it is written
+class CHESS_2_API FChessReplayWriter
+{
+public:
+	~FChessReplayWriter();
+
+	bool Open(const FString& Filename, const FChessReplayHeader& Header, const FChessPosition& StartPosition);
+	void AppendMove(uint16 Move, uint32 ClockMs, const FChessPosition& PositionAfterMove);
+	void Close();
+
+	FORCEINLINE bool IsOpen() const { return FileHandle.IsValid(); }
+	FORCEINLINE int32 GetNumPlies() const { return NumPlies; }
+
+private:
+	bool Write(const uint8* Data, int64 Size); // False and the file is closed if the write failed
+
+	TUniquePtr<class IFileHandle> FileHandle;
+	FChessReplayHeader WrittenHeader;
+	int32 NumPlies = 0;
+};
+
+// Reads a replay through a memory mapping where the platform has one, otherwise from a copy in memory
+class CHESS_2_API FChessReplayReader
+{
+public:
+	~FChessReplayReader();
+
+	bool Open(const FString& Filename);
+	void Close();
+
+	int32 GetNumPlies() const;
+	uint16 GetMove(int32 Ply) const; // Move that takes the game from Ply to Ply + 1
+	uint32 GetClockMs(int32 Ply) const;
+	bool GetPositionAtPly(int32 Ply, FChessPosition& OutPosition) const; // Nearest snapshot plus at most N - 1 moves
+
+	FORCEINLINE bool IsOpen() const { return Data != nullptr; }
+	FORCEINLINE const FChessReplayHeader& GetHeader() const { return Header; }
+
+private:
+	int64 GetMoveRecordOffset(int32 Ply) const;
+
+	TUniquePtr<class IMappedFileHandle> MappedFile;
+	TUniquePtr<class IMappedFileRegion> MappedRegion;
+	TArray<uint8> LoadedFile;
+
+	const uint8* Data = nullptr;
+	int64 DataSize = 0;
+	FChessReplayHeader Header;
+};
@@ -0,0 +1,64 @@
+// Copyright (©) 2024, Van Phan. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Utility/ChessPosition.h"
+#include "Utility/ChessMoveGenerator.h"
+#include <atomic>
+
+struct FChessSearchLimits
+{
+	double TimeLimitSeconds = 0.0; // 0 = no time limit
+	uint64 NodeLimit = 0; // 0 = no node limit
+	int32 MaxDepth = 64;
+	int32 MultiPV = 1; // Best lines to find at every depth, each one excludes the first moves of the lines before it
+};
+
+struct FChessSearchLine
+{
+	TArray<uint16> Moves;
+	int32 Score = 0; // Centipawns for the side to move, mates are near FChessSearch::MateScore
+};
+
+struct FChessSearchResult
+{
+	uint16 BestMove = ChessMove::None;
+	int32 Score = 0;
+	int32 Depth = 0; // Last depth that finished, the lines below come from it
+	uint64 Nodes = 0;
+	double Seconds = 0.0;
+	TArray<FChessSearchLine> Lines;
+
+	FORCEINLINE uint64 GetNodesPerSecond() const { return Seconds > 0.0 ? (uint64)(Nodes / Seconds) : 0; }
+};
+
+/**
+ * Iterative deepening alpha-beta on FChessPosition with a quiescence search. One instance per thread, it keeps no state
+ * between searches so any number can run side by side
+ */
+class CHESS_2_API FChessSearch
+{
+public:
+	static constexpr int32 MateScore = 30000;
+	static constexpr int32 MaxPly = 64;
+
+	// Stop can be flipped from any thread to end the search early, OnDepthCompleted is called on the searching thread
+	FChessSearchResult Search(const FChessPosition& Root, const FChessSearchLimits& Limits, const std::atomic<bool>* Stop = nullptr, TFunction<void(const FChessSearchResult&)> OnDepthCompleted = nullptr);
+
+	static int32 Evaluate(const FChessPosition& Position); // Material and piece placement for the side to move
+	static FORCEINLINE bool IsMateScore(int32 Score) { return FMath::Abs(Score) >= MateScore - MaxPly; }
+
+private:
+	FChessSearchLimits Limits;
+	const std::atomic<bool>* ExternalStop = nullptr;
+	double StartTime = 0.0;
+	uint64 Nodes = 0;
+	bool bStopped = false;
+	uint16 PreviousPv[MaxPly]; // Last iteration's best line, tried first at the same ply
+
+	int32 Negamax(const FChessPosition& Position, int32 Depth, int32 Alpha, int32 Beta, int32 Ply, TArray<uint16>& OutLine);
+	int32 Quiesce(const FChessPosition& Position, int32 Alpha, int32 Beta, int32 Ply);
+	void OrderMoves(const FChessPosition& Position, FChessMoveList& Moves, uint16 FirstMove) const;
+	bool ShouldStop();
+};